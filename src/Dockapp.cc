@@ -63,7 +63,7 @@ DockappHandler::DockappHandler(WaScreen *scrn, DockStyle *ds) :
     attrib_set.colormap = wascreen->colormap;
     attrib_set.override_redirect = true;
     attrib_set.event_mask = SubstructureRedirectMask | ButtonPressMask |
-        EnterWindowMask | LeaveWindowMask;
+        EnterWindowMask | LeaveWindowMask | ExposureMask;
 
     id = XCreateWindow(display, wascreen->id, 0, 0, 1, 1,
                        style->style.border_width, wascreen->screen_depth,
@@ -84,6 +84,10 @@ DockappHandler::DockappHandler(WaScreen *scrn, DockStyle *ds) :
         wm_strut->right = 0;
         wm_strut->top = 0;
         wm_strut->bottom = 0;
+        wm_strut->left_start = wm_strut->right_start = 0;
+        wm_strut->left_end = wm_strut->right_end = wascreen->height - 1;
+        wm_strut->top_start = wm_strut->bottom_start = 0;
+        wm_strut->top_end = wm_strut->bottom_end = wascreen->width - 1;
         wascreen->strut_list.push_back(wm_strut);
     }
     waimea->window_table.insert(make_pair(id, this));
@@ -285,7 +289,7 @@ void DockappHandler::Render(void) {
     }
 #endif // RENDER
 
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         background = None;
         background_pixel = texture->getColor()->getPixel();
 #ifdef RENDER
@@ -320,12 +324,23 @@ void DockappHandler::Render(void) {
         XSetWindowBackgroundPixmap(display, id, background);
     }
     XClearWindow(display, id);
+    Draw();
 
 #ifdef RENDER
     if (texture->getOpacity()) XFreePixmap(wascreen->pdisplay, background);
 #endif // RENDER
 }
 
+/**
+ * @fn    Draw(void)
+ * @brief Draw foreground
+ *
+ * Draws bevel for solid dockapp holder textures.
+ */
+void DockappHandler::Draw(void) {
+    wascreen->ic->drawSolid(id, width, height, &style->style.texture);
+}
+
 /**
  * @fn    Dockapp(Window win, DockappHandler *dhand)
  * @brief Constructor for Dockapp class
@@ -27,6 +27,7 @@ public:
 
     void Update(void);
     void Render(void);
+    void Draw(void);
 
     Display *display;
     Waimea *waimea;
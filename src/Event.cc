@@ -35,8 +35,18 @@ extern "C" {
 #ifdef    HAVE_STRING_H
 #  include <string.h>
 #endif // HAVE_STRING_H
+
+#ifdef    HAVE_SYS_SELECT_H
+#  include <sys/select.h>
+#endif // HAVE_SYS_SELECT_H
+
+#include <time.h>
 }
 
+#include <iostream>
+using std::cerr;
+using std::endl;
+
 #include "Event.hh"
 
 /**
@@ -44,16 +54,22 @@ extern "C" {
  * @brief Constructor for EventHandler class
  *
  * Sets waimea and rh pointers. Creates menu move return mask, window
- * move/resize return mask and empty return mask sets.
+ * move/resize return mask and empty return mask sets. Creates action used
+ * for ending key sequences when they time out.
  *
  * @param wa Pointer to waimea object
  */
 EventHandler::EventHandler(Waimea *wa) {
     waimea = wa;
     rh = waimea->rh;
-    focused = last_click_win = (Window) 0;
+    focused = (Window) 0;
+    last_time = CurrentTime;
     move_resize = EndMoveResizeType;
-    last_button = 0;
+
+    keyseq = NULL;
+    keyseq_window = None;
+
+    flush_pending = hold_pending = false;
 
     empty_return_mask = new set<int>;
 
@@ -85,7 +101,7 @@ EventHandler::EventHandler(Waimea *wa) {
  * @fn    ~EventHandler(void)
  * @brief Destructor for EventHandler class
  *
- * Deletes return mask lists
+ * Deletes return mask lists and key sequence timeout action.
  */
 EventHandler::~EventHandler(void) {
     MAPPTRCLEAR(empty_return_mask);
@@ -100,13 +116,35 @@ EventHandler::~EventHandler(void) {
  * Infinite loop waiting for an event to occur. This function can be called
  * from move and resize functions the return_mask set is then used for
  * deciding if an event should be processed as normal or returned to the
- * function caller.
+ * function caller. SIGCHLD is blocked except while the loop waits in
+ * pselect(), so a child exiting right before the wait still wakes the loop
+ * and is reaped promptly.
  *
  * @param return_mask set to use as return_mask
  * @param event Pointer to allocated event structure
  */
 void EventHandler::EventLoop(set<int> *return_mask, XEvent *event) {
+    int fd = ConnectionNumber(waimea->display);
+    struct timeval tv;
+    struct timespec ts;
+    fd_set rfds;
+
     for (;;) {
+        waimea->ReapChildren();
+        RunTimeouts();
+        if (! XPending(waimea->display)) {
+            FD_ZERO(&rfds);
+            FD_SET(fd, &rfds);
+            if (NextTimeout(&tv)) {
+                ts.tv_sec = tv.tv_sec;
+                ts.tv_nsec = tv.tv_usec * 1000;
+                if (pselect(fd + 1, &rfds, NULL, NULL, &ts,
+                            &waimea->sigmask) == 0 && hold_pending)
+                    hold_clock += tv.tv_sec * 1000 + tv.tv_usec / 1000;
+            } else
+                pselect(fd + 1, &rfds, NULL, NULL, NULL, &waimea->sigmask);
+            continue;
+        }
         XNextEvent(waimea->display, event);
 
         if (return_mask->find(event->type) != return_mask->end()) return;
@@ -128,13 +166,35 @@ void EventHandler::EventLoop(set<int> *return_mask, XEvent *event) {
 void EventHandler::HandleEvent(XEvent *event) {
     Window w;
     int i, rx, ry;
-    struct timeval click_time;
+    bool hold;
 
     EventDetail *ed = new EventDetail;
 
+    switch (event->type) {
+        case KeyPress:
+        case KeyRelease:
+            last_time = event->xkey.time; break;
+        case ButtonPress:
+        case ButtonRelease:
+            last_time = event->xbutton.time; break;
+        case MotionNotify:
+            last_time = event->xmotion.time; break;
+        case EnterNotify:
+        case LeaveNotify:
+            last_time = event->xcrossing.time; break;
+        case PropertyNotify:
+            last_time = event->xproperty.time; break;
+    }
+    if (hold_pending && last_time != CurrentTime) {
+        hold_clock = last_time;
+        CheckHold();
+    }
+
     switch (event->type) {
         case ConfigureRequest:
-            EvConfigureRequest(&event->xconfigurerequest); break;
+            if (! ThrottleRequest(event))
+                EvConfigureRequest(&event->xconfigurerequest);
+            break;
         case Expose:
             if (event->xexpose.count == 0) {
                 while (XCheckTypedWindowEvent(waimea->display,
@@ -144,7 +204,8 @@ void EventHandler::HandleEvent(XEvent *event) {
             }
             break;
         case PropertyNotify:
-            EvProperty(&event->xproperty); break;
+            if (! ThrottleRequest(event)) EvProperty(&event->xproperty);
+            break;
         case UnmapNotify:
             if(event->xunmap.event != event->xunmap.window) return;
         case DestroyNotify:
@@ -162,55 +223,51 @@ void EventHandler::HandleEvent(XEvent *event) {
             break;
         case KeyPress:
         case KeyRelease:
+            if (keyseq) {
+                if (event->type == KeyPress) EvKeySequence(&event->xkey);
+                break;
+            }
             ed->type = event->type;
             ed->mod = event->xkey.state;
             ed->detail = event->xkey.keycode;
             EvAct(event, event->xkey.window, ed);
             break;
         case ButtonPress:
-            ed->type = ButtonPress;
-            if (last_button == event->xbutton.button &&
-                last_click_win == event->xbutton.window) {
-                gettimeofday(&click_time, NULL);
-                if (click_time.tv_sec <= last_click.tv_sec + 1) {
-                    if (click_time.tv_sec == last_click.tv_sec &&
-                        (unsigned long)
-                        (click_time.tv_usec - last_click.tv_usec) <
-                        waimea->double_click * 1000) {
-                        ed->type = DoubleClick;
-                        last_click_win = (Window) 0;
-                    }
-                    else if ((1000000 - last_click.tv_usec) +
-                             (unsigned long) click_time.tv_usec <
-                             waimea->double_click * 1000) {
-                        ed->type = DoubleClick;
-                        last_click_win = (Window) 0;
-                    }
-                    else {
-                        last_click_win = event->xbutton.window;
-                        last_click.tv_sec = click_time.tv_sec;
-                        last_click.tv_usec = click_time.tv_usec;
-                    }
-                }
-                else {
-                    last_click_win = event->xbutton.window;
-                    last_click.tv_sec = click_time.tv_sec;
-                    last_click.tv_usec = click_time.tv_usec;
-                }
-            }
-            else {
-                last_click_win = event->xbutton.window;
-                gettimeofday(&last_click, NULL);
-            }
-            last_button = event->xbutton.button;
-        case ButtonRelease:
-            if (event->type == ButtonRelease) ed->type = ButtonRelease;
+            ed->type = click.Press(&event->xbutton, waimea->double_click);
             ed->mod = event->xbutton.state;
             ed->detail = event->xbutton.button;
+            hold_event = *event;
+            hold_pending = true;
+            hold_clock = event->xbutton.time;
+            hold_expiry = event->xbutton.time + waimea->hold_time;
             EvAct(event, event->xbutton.window, ed);
             break;
+        case ButtonRelease:
+            w = event->xbutton.window;
+            hold = click.Release(&event->xbutton, waimea->hold_time);
+            if (hold_pending &&
+                event->xbutton.button == hold_event.xbutton.button) {
+                hold_pending = false;
+                if (hold) ButtonHoldAct(&hold_event);
+            }
+            ed->type = ButtonRelease;
+            ed->mod = event->xbutton.state;
+            ed->detail = event->xbutton.button;
+            EvAct(event, w, ed);
+            break;
+        case MotionNotify:
+            if (click.Motion(&event->xmotion, waimea->drag_threshold)) {
+                hold_pending = false;
+                ed->type = ButtonDrag;
+                ed->mod = event->xmotion.state;
+                ed->detail = click.button;
+                EvAct(event, click.window, ed);
+            }
+            break;
         case ColormapNotify:
             EvColormap(&event->xcolormap); break;
+        case MappingNotify:
+            EvMapping(&event->xmapping); break;
         case MapRequest:
             EvMapRequest(&event->xmaprequest);
             ed->type = event->type;
@@ -222,7 +279,7 @@ void EventHandler::HandleEvent(XEvent *event) {
             EvAct(event, event->xmaprequest.window, ed);
             break;
         case ClientMessage:
-            EvClientMessage(event, ed);
+            if (! ThrottleRequest(event)) EvClientMessage(event, ed);
             break;
 
         default:
@@ -254,6 +311,101 @@ void EventHandler::HandleEvent(XEvent *event) {
     delete ed;
 }
 
+/**
+ * @fn    ClickRecognizer(void)
+ * @brief Constructor for ClickRecognizer class
+ *
+ * Click recognizer is driven by X server timestamps only, so it is
+ * unaffected by system clock changes.
+ */
+ClickRecognizer::ClickRecognizer(void) {
+    window = (Window) 0;
+    button = 0;
+    time = 0;
+    count = x = y = 0;
+    pressed = dragged = false;
+}
+
+/**
+ * @fn    Press(XButtonEvent *e, unsigned long interval)
+ * @brief Button press
+ *
+ * Counts presses of the same button on the same window within interval
+ * milliseconds of each other.
+ *
+ * @param e The ButtonPress event
+ * @param interval Multiple click interval in milliseconds
+ *
+ * @return Event type to use for action matching, ButtonPress,
+ *         DoubleClick or TripleClick
+ */
+unsigned int ClickRecognizer::Press(XButtonEvent *e, unsigned long interval) {
+    if (count && count < 3 && e->window == window && e->button == button &&
+        (CARD32) (e->time - time) < interval)
+        count++;
+    else
+        count = 1;
+
+    window = e->window;
+    button = e->button;
+    time = e->time;
+    x = e->x_root;
+    y = e->y_root;
+    pressed = true;
+    dragged = false;
+
+    switch (count) {
+        case 2: return DoubleClick;
+        case 3: return TripleClick;
+    }
+    return ButtonPress;
+}
+
+/**
+ * @fn    Release(XButtonEvent *e, unsigned long hold)
+ * @brief Button release
+ *
+ * @param e The ButtonRelease event
+ * @param hold Hold time in milliseconds
+ *
+ * @return True if button was held down at least hold milliseconds
+ *         without being dragged, otherwise false
+ */
+bool ClickRecognizer::Release(XButtonEvent *e, unsigned long hold) {
+    if (! pressed || e->button != button) return false;
+    pressed = false;
+
+    return (! dragged && (CARD32) (e->time - time) >= hold);
+}
+
+/**
+ * @fn    Motion(XMotionEvent *e, int threshold)
+ * @brief Pointer motion
+ *
+ * A drag starts when pointer has moved threshold pixels from where the
+ * button was pressed, while the button is still down. A drag ends any
+ * multiple click sequence.
+ *
+ * @param e The MotionNotify event
+ * @param threshold Drag threshold in pixels
+ *
+ * @return True if a drag was started, otherwise false
+ */
+bool ClickRecognizer::Motion(XMotionEvent *e, int threshold) {
+    if (! pressed || dragged) return false;
+    if (button >= Button1 && button <= Button5 &&
+        ! (e->state & (Button1Mask << (button - Button1)))) {
+        pressed = false;
+        return false;
+    }
+    if (abs(e->x_root - x) < threshold && abs(e->y_root - y) < threshold)
+        return false;
+
+    dragged = true;
+    count = 0;
+    return true;
+}
+
 /**
  * @fn    EvProperty(XPropertyEvent *e)
  * @brief PropertyEvent handler
@@ -264,29 +416,27 @@ void EventHandler::HandleEvent(XEvent *event) {
  * WaWindow was found, we update the stuff indicated by the event. If the
  * name should be updated we also redraw the label foreground for the
  * WaWindow. If atom is _NET_WM_STRUT we update the strut list and workarea.
+ * Changed size hints are reread so that new size constraints are used.
  *
  * @param e	The PropertyEvent
  */
 void EventHandler::EvProperty(XPropertyEvent *e) {
     WaWindow *ww;
 
-    if (e->state == PropertyDelete) {
-        if (e->atom == waimea->net->net_wm_strut) {
-            if ((ww = (WaWindow *) waimea->FindWin(e->window, WindowType))) {
-                list<WMstrut *>::iterator s_it =
-                    ww->wascreen->strut_list.begin();
-                for (; s_it != ww->wascreen->strut_list.end(); ++s_it) {
-                    if ((*s_it)->window == e->window) {
-                        ww->wascreen->strut_list.remove(*s_it);
-                        free(*s_it);
-                        ww->wascreen->UpdateWorkarea();
-                    }
-                }
-            }
-        }
-    } else if (e->atom == waimea->net->net_wm_strut) {
+    if (e->atom == waimea->net->net_wm_strut ||
+        e->atom == waimea->net->net_wm_strut_partial) {
         if ((ww = (WaWindow *) waimea->FindWin(e->window, WindowType)))
             waimea->net->GetWmStrut(ww);
+    } else if (e->atom == waimea->net->net_wm_icon) {
+        if ((ww = (WaWindow *) waimea->FindWin(e->window, WindowType))) {
+            waimea->net->GetWmIcon(ww);
+            ww->wascreen->UpdateIcons(ww->id);
+        }
+    } else if (e->state == PropertyDelete) {
+        return;
+    } else if (e->atom == XA_WM_NORMAL_HINTS) {
+        if ((ww = (WaWindow *) waimea->FindWin(e->window, WindowType)))
+            waimea->net->GetWMNormalHints(ww);
     } else if (e->atom == XA_WM_NAME) {
         if ((ww = (WaWindow *) waimea->FindWin(e->window, WindowType))) {
             waimea->net->GetXaName(ww);
@@ -299,10 +449,23 @@ void EventHandler::EvProperty(XPropertyEvent *e) {
     }
 #ifdef RENDER
     else if (e->atom == waimea->net->xrootpmap_id) {
-        if (WaScreen *ws = (WaScreen *) waimea->FindWin(e->window, RootType)) {
+        WaScreen *ws = (WaScreen *) waimea->FindWin(e->window, RootType);
+
+        // decorations using ARGB visual don't depend on root background
+        if (ws && ! ws->argb_visual) {
+            Pixmap old = ws->xrootpmap_id;
+            bool keep = false;
             waimea->net->GetXRootPMapId(ws);
             ws->ic->setXRootPMapId((ws->xrootpmap_id)? true: false);
 
+#ifdef PIXMAP
+            list<Desktop *>::iterator dit = ws->desktop_list.begin();
+            for (; dit != ws->desktop_list.end(); ++dit)
+                if ((*dit)->background == old) keep = true;
+#endif // PIXMAP
+
+            if (! keep) ws->ic->removeXRender(old);
+
             list<DockappHandler *>::iterator dock_it = ws->docks.begin();
             for (; dock_it != ws->docks.end(); ++dock_it)
                 if ((*dock_it)->dockapp_list->size()) (*dock_it)->Render();
@@ -327,19 +490,35 @@ void EventHandler::EvProperty(XPropertyEvent *e) {
  *
  * We receive an expose event when a windows foreground has been exposed
  * for some change. If the event is from one of our windows with
- * foreground, we redraw the foreground for this window.
+ * foreground, we redraw the foreground for this window. Bevels of solid
+ * textures are drawn on top of the window background and are redrawn here
+ * as well.
  *
  * @param e	The ExposeEvent
  */
 void EventHandler::EvExpose(XExposeEvent *e) {
     if (WindowObject *wo = waimea->FindWin(e->window, LabelType | ButtonType |
+                                           TitleType | HandleType |
+                                           LGripType | RGripType |
                                            MenuTitleType | MenuItemType |
-                                           MenuSubType | MenuCBItemType))
+                                           MenuSubType | MenuCBItemType |
+                                           DockHandlerType))
         switch (wo->type) {
             case LabelType:
                 if (! ((WaChildWindow *) wo)->wa->wascreen->config.db)
                     ((WaChildWindow *) wo)->Draw();
                 break;
+            case TitleType:
+            case HandleType:
+            case LGripType:
+            case RGripType: {
+                WaChildWindow *wc = (WaChildWindow *) wo;
+                wc->ic->drawSolid(wc->id, wc->attrib.width, wc->attrib.height,
+                                  (wc->wa->has_focus)? wc->f_texture:
+                                  wc->u_texture);
+            } break;
+            case DockHandlerType:
+                ((DockappHandler *) wo)->Draw(); break;
             case ButtonType:
                 ((WaChildWindow *) wo)->Draw(); break;
             case MenuTitleType:
@@ -351,6 +530,30 @@ void EventHandler::EvExpose(XExposeEvent *e) {
         }
 }
 
+/**
+ * @fn    focuswindow(Window w)
+ * @brief Find window for focus window
+ *
+ * Focus is normally set to client windows but is set to frame window
+ * while client window is unmapped because the window is shaded.
+ *
+ * @param waimea Waimea object
+ * @param w Window that got focus
+ *
+ * @return WaWindow having focus, NULL if w isn't a managed window
+ */
+static WaWindow *focuswindow(Waimea *waimea, Window w) {
+    WindowObject *wo = waimea->FindWin(w, WindowType | FrameType);
+    if (! wo) return NULL;
+    if (wo->type == WindowType) return (WaWindow *) wo;
+
+    WaWindow *ww = ((WaChildWindow *) wo)->wa;
+    list<WaWindow *>::iterator it = ww->merged.begin();
+    for (; it != ww->merged.end(); ++it)
+        if ((*it)->has_focus && (*it)->client_unmapped) return *it;
+    return (ww->client_unmapped)? ww: NULL;
+}
+
 /**
  * @fn    EvFocus(XFocusChangeEvent *e)
  * @brief FocusChangeEvent handler
@@ -367,7 +570,8 @@ void EventHandler::EvFocus(XFocusChangeEvent *e) {
     WaScreen *ws = NULL;
 
     if (e->type == FocusIn && e->window != focused) {
-        ww = (WaWindow *) waimea->FindWin(e->window, WindowType);
+        ww = focuswindow(waimea, e->window);
+        if (! ww && waimea->FindWin(e->window, FrameType)) return;
         if (ww) {
             ww->actionlist =
                 ww->GetActionList(&ww->wascreen->config.ext_awinacts);
@@ -379,7 +583,7 @@ void EventHandler::EvFocus(XFocusChangeEvent *e) {
         } else if ((ws = (WaScreen *) waimea->FindWin(e->window, RootType)))
             ws->focus = true;
 
-        if ((ww2 = (WaWindow *) waimea->FindWin(focused, WindowType))) {
+        if ((ww2 = focuswindow(waimea, focused))) {
             ww2->actionlist =
                 ww2->GetActionList(&ww2->wascreen->config.ext_pwinacts);
             if (! ww2->actionlist)
@@ -474,12 +678,42 @@ void EventHandler::EvConfigureRequest(XConfigureRequestEvent *e) {
  * @fn    EvColormap(XColormapEvent *e)
  * @brief ColormapEvent handler
  *
- * A window wants to install a new colormap, so we do it.
+ * A window has changed its colormap or a colormap has been uninstalled.
+ * New colormap is installed if window has focus. If the colormap we
+ * installed last is uninstalled it has to be installed again next time.
  *
  * @param e	The ColormapEvent
  */
 void EventHandler::EvColormap(XColormapEvent *e) {
-    XInstallColormap(e->display, e->colormap);
+    WaWindow *ww = (WaWindow *) waimea->FindWin(e->window, WindowType);
+
+    if (e->c_new) {
+        if (ww) {
+            ww->attrib.colormap = e->colormap;
+            if (ww->has_focus) ww->wascreen->InstallColormap(e->colormap);
+        } else
+            XInstallColormap(e->display, e->colormap);
+    }
+    else if (e->state == ColormapUninstalled) {
+        list<WaScreen *>::iterator it = waimea->wascreen_list.begin();
+        for (; it != waimea->wascreen_list.end(); ++it)
+            if ((*it)->installed_colormap == e->colormap)
+                (*it)->installed_colormap = None;
+    }
+}
+
+/**
+ * @fn    EvMapping(XMappingEvent *e)
+ * @brief MappingEvent handler
+ *
+ * Keyboard mapping has changed, so we refresh Xlib's copy of it and
+ * rebind key actions which keysyms moved to other keycodes.
+ *
+ * @param e	The MappingEvent
+ */
+void EventHandler::EvMapping(XMappingEvent *e) {
+    XRefreshKeyboardMapping(e);
+    if (e->request == MappingKeyboard) waimea->rh->UpdateKeycodes();
 }
 
 /**
@@ -556,9 +790,15 @@ void EventHandler::EvUnmapDestroy(XEvent *e) {
                               e->xreparent.window,
                               WindowType | DockAppType | SystrayType))) {
         if (wo->type == WindowType) {
+            WaWindow *ww = (WaWindow *) wo;
+            if (e->type == UnmapNotify && ! e->xunmap.send_event &&
+                ww->ign_unmap) {
+                ww->ign_unmap--;
+                return;
+            }
             if (e->type == DestroyNotify)
-                ((WaWindow *) wo)->deleted = true;
-            delete ((WaWindow *) wo);
+                ww->deleted = true;
+            delete ww;
         }
         else if (wo->type == DockAppType) {
             if (e->type == DestroyNotify)
@@ -597,6 +837,7 @@ void EventHandler::EvClientMessage(XEvent *e, EventDetail *ed) {
     WaWindow *ww;
 
     if (e->xclient.message_type == waimea->net->net_active_window) {
+        if (e->xclient.data.l[1]) last_time = e->xclient.data.l[1];
         if ((ww = (WaWindow *) waimea->FindWin(e->xclient.window,
                                                WindowType)))
             ww->RaiseFocus(NULL, NULL);
@@ -852,6 +1093,10 @@ void EventHandler::EvClientMessage(XEvent *e, EventDetail *ed) {
                                                         RootType))
             ws->MoveViewportTo(e->xclient.data.l[0], e->xclient.data.l[1]);
     }
+    else if (e->xclient.message_type ==
+             waimea->net->net_request_frame_extents) {
+        waimea->net->SetRequestedFrameExtents(e->xclient.window);
+    }
     else if (e->xclient.message_type == waimea->net->net_close_window) {
         if ((ww = (WaWindow *) waimea->FindWin(e->xclient.window, WindowType)))
             ww->Close(NULL, NULL);
@@ -1000,6 +1245,373 @@ void EventHandler::EvAct(XEvent *e, Window win, EventDetail *ed) {
     }
 }
 
+/**
+ * @fn    ExecAction(WaAction *act, XEvent *e, Window win)
+ * @brief Executes action
+ *
+ * Finds the WindowObject for window and executes action for it. Used for
+ * actions that are not executed directly from the objects EvAct function,
+ * delayed actions and key sequence actions.
+ *
+ * @param act Action to execute
+ * @param e Event to pass to action function
+ * @param win Window of WindowObject to execute action for
+ */
+void EventHandler::ExecAction(WaAction *act, XEvent *e, Window win) {
+    map<Window, WindowObject *>::iterator wit;
+    if ((wit = waimea->window_table.find(win)) !=
+        waimea->window_table.end()) {
+        WindowObject *wo = (*wit).second;
+
+        switch (wo->type) {
+            case WindowType: {
+                WaWindow *wa = (WaWindow *) wo;
+                if (act->exec)
+                    waexec(act->exec, wa->wascreen);
+                else {
+                    ((*wa).*(act->winfunc))(e, act);
+                    XSync(wa->display, false);
+                }
+            } break;
+            case MenuTitleType:
+            case MenuItemType:
+            case MenuCBItemType:
+            case MenuSubType: {
+                WaMenuItem *wm = (WaMenuItem *) wo;
+                if (act->exec)
+                    waexec(act->exec, wm->menu->wascreen);
+                else {
+                    ((*wm).*(act->menufunc))(e, act);
+                    XSync(wm->menu->display, false);
+                }
+            } break;
+            case RootType: {
+                WaScreen *ws = (WaScreen *) wo;
+                if (act->exec)
+                    waexec(act->exec, ws);
+                else {
+                    ((*ws).*(act->rootfunc))(e, act);
+                    XSync(ws->display, false);
+                }
+            } break;
+        }
+    }
+}
+
+/**
+ * @fn    StartKeySequence(KeySequence *seq, XEvent *e, Window win)
+ * @brief Starts key sequence
+ *
+ * Grabs keyboard so that following key strokes are received no matter
+ * which window has focus, and starts key sequence timeout. The timeout is
+ * run from the event loop.
+ *
+ * @param seq Key sequence trie holding following key strokes
+ * @param e KeyPress event for first key stroke
+ * @param win Window of WindowObject to execute sequence actions for
+ */
+void EventHandler::StartKeySequence(KeySequence *seq, XEvent *e,
+                                    Window win) {
+    if (keyseq || move_resize != EndMoveResizeType) return;
+
+    if (XGrabKeyboard(waimea->display, e->xkey.root, false, GrabModeAsync,
+                      GrabModeAsync, e->xkey.time) != GrabSuccess)
+        return;
+
+    keyseq = seq;
+    keyseq_event = *e;
+    keyseq_window = win;
+    monotonic_time(&keyseq_time, waimea->key_sequence_timeout);
+}
+
+/**
+ * @fn    EndKeySequence(void)
+ * @brief Ends key sequence
+ *
+ * Discards pending key sequence, removes its timeout and releases keyboard.
+ */
+void EventHandler::EndKeySequence(void) {
+    if (! keyseq) return;
+
+    keyseq = NULL;
+    XUngrabKeyboard(waimea->display, CurrentTime);
+}
+
+/**
+ * @fn    EvKeySequence(XKeyEvent *e)
+ * @brief KeyPress event during key sequence
+ *
+ * Advances pending key sequence one trie node. If the node holds actions
+ * the sequence is completed and the actions are executed. A key stroke not
+ * continuing any sequence ends the sequence, modifier keys are ignored.
+ *
+ * @param e The KeyPressEvent
+ */
+void EventHandler::EvKeySequence(XKeyEvent *e) {
+    KeySym keysym = XLookupKeysym(e, 0);
+    if (IsModifierKey(keysym)) return;
+
+    KeySequence *node = keyseq->Next(keysym, e->state);
+    if (node && node->acts.empty()) {
+        keyseq = node;
+        monotonic_time(&keyseq_time, waimea->key_sequence_timeout);
+        return;
+    }
+
+    XEvent ev = keyseq_event;
+    Window win = keyseq_window;
+    EndKeySequence();
+    if (node) {
+        list<WaAction *>::iterator it = node->acts.begin();
+        for (; it != node->acts.end(); ++it)
+            ExecAction(*it, &ev, win);
+    }
+}
+
+/**
+ * @fn    ThrottleRequest(XEvent *e)
+ * @brief Request rate limiter
+ *
+ * Accounts configure requests, property changes and client messages from
+ * managed windows in a token bucket per window, refilled with requestRate
+ * tokens per second. Requests over budget are queued and collapsed with
+ * earlier queued requests of the same kind, so that only the latest state
+ * is applied when the queue is flushed. A collapsed request takes the
+ * queue position of the latest request, so queued requests are applied in
+ * arrival order. _NET_WM_STATE messages are only collapsed with messages
+ * doing the same action on the same states, toggles are never collapsed.
+ * Changes to properties maintained by waimea itself are neither accounted
+ * nor queued.
+ *
+ * @param e Event to account
+ *
+ * @return True if event was queued, false if it should be handled now
+ */
+bool EventHandler::ThrottleRequest(XEvent *e) {
+    struct timeval now;
+    double elapsed;
+    Window win;
+    WaWindow *ww;
+
+    if (! waimea->request_rate) return false;
+    if (e->type == ConfigureRequest) win = e->xconfigurerequest.window;
+    else win = e->xany.window;
+    if (! (ww = (WaWindow *) waimea->FindWin(win, WindowType)))
+        return false;
+    if (e->type == PropertyNotify &&
+        waimea->net->IsWmProperty(e->xproperty.atom))
+        return false;
+
+    monotonic_time(&now);
+    elapsed = (now.tv_sec - ww->req_time.tv_sec) +
+        (now.tv_usec - ww->req_time.tv_usec) / 1000000.0;
+    if (elapsed > 0.0) ww->req_tokens += elapsed * waimea->request_rate;
+    if (ww->req_tokens > waimea->request_rate)
+        ww->req_tokens = waimea->request_rate;
+    ww->req_time = now;
+
+    if (ww->req_queue.empty() && ww->req_tokens >= 1.0) {
+        ww->req_tokens -= 1.0;
+        ww->req_throttled = false;
+        return false;
+    }
+
+    XEvent *qe = NULL;
+    list<XEvent *>::iterator it = ww->req_queue.begin();
+    for (; it != ww->req_queue.end(); ++it) {
+        if ((*it)->type != e->type) continue;
+        if (e->type == ConfigureRequest) {
+            XConfigureRequestEvent *q = &(*it)->xconfigurerequest;
+            XConfigureRequestEvent *n = &e->xconfigurerequest;
+            if (! (n->value_mask & CWX)) n->x = q->x;
+            if (! (n->value_mask & CWY)) n->y = q->y;
+            if (! (n->value_mask & CWWidth)) n->width = q->width;
+            if (! (n->value_mask & CWHeight)) n->height = q->height;
+            if (! (n->value_mask & CWBorderWidth))
+                n->border_width = q->border_width;
+            if (! (n->value_mask & CWSibling)) n->above = q->above;
+            if (! (n->value_mask & CWStackMode)) n->detail = q->detail;
+            n->value_mask |= q->value_mask;
+        }
+        else if (e->type == PropertyNotify) {
+            if ((*it)->xproperty.atom != e->xproperty.atom) continue;
+        }
+        else if ((*it)->xclient.message_type != e->xclient.message_type ||
+                 (e->xclient.message_type == waimea->net->net_wm_state &&
+                  (e->xclient.data.l[0] == _NET_WM_STATE_TOGGLE ||
+                   (*it)->xclient.data.l[0] != e->xclient.data.l[0] ||
+                   (*it)->xclient.data.l[1] != e->xclient.data.l[1] ||
+                   (*it)->xclient.data.l[2] != e->xclient.data.l[2])))
+            continue;
+        qe = *it;
+        ww->req_queue.erase(it);
+        break;
+    }
+
+    if (! qe) qe = new XEvent;
+    *qe = *e;
+    ww->req_queue.push_back(qe);
+    if (! ww->req_throttled) {
+        ww->req_throttled = true;
+        WARNING << "throttling requests from `" << ww->name << "'" << endl;
+    }
+    if (! flush_pending) {
+        flush_pending = true;
+        monotonic_time(&flush_time, RequestFlushDelay);
+    }
+    return true;
+}
+
+/**
+ * @fn    FlushRequests(void)
+ * @brief Applies throttled requests
+ *
+ * Handles all requests queued by ThrottleRequest(). Windows may disappear
+ * while their requests are handled, so each window is looked up again
+ * before its next request is handled. Called from the event loop.
+ */
+void EventHandler::FlushRequests(void) {
+    list<Window> wins;
+    WaWindow *ww;
+    XEvent ev;
+    EventDetail ed;
+
+    list<WaScreen *>::iterator sit = waimea->wascreen_list.begin();
+    for (; sit != waimea->wascreen_list.end(); ++sit) {
+        list<WaWindow *>::iterator it = (*sit)->wawindow_list.begin();
+        for (; it != (*sit)->wawindow_list.end(); ++it)
+            if (! (*it)->req_queue.empty()) wins.push_back((*it)->id);
+    }
+
+    list<Window>::iterator it = wins.begin();
+    for (; it != wins.end(); ++it) {
+        while ((ww = (WaWindow *) waimea->FindWin(*it, WindowType)) &&
+               ! ww->req_queue.empty()) {
+            XEvent *qe = ww->req_queue.front();
+            ww->req_queue.pop_front();
+            ev = *qe;
+            delete qe;
+            switch (ev.type) {
+                case ConfigureRequest:
+                    EvConfigureRequest(&ev.xconfigurerequest); break;
+                case PropertyNotify:
+                    EvProperty(&ev.xproperty); break;
+                case ClientMessage:
+                    EvClientMessage(&ev, &ed); break;
+            }
+        }
+    }
+}
+
+/**
+ * @fn    NextTimeout(struct timeval *tv)
+ * @brief Time left until next event loop timeout
+ *
+ * @param tv Returns time left until the earliest pending timeout
+ *
+ * @return True if a timeout is pending, otherwise false
+ */
+bool EventHandler::NextTimeout(struct timeval *tv) {
+    struct timeval now, left, *due = NULL;
+    bool pending = false;
+
+    if (flush_pending) due = &flush_time;
+    if (keyseq && (! due || timercmp(&keyseq_time, due, <)))
+        due = &keyseq_time;
+    if (due) {
+        monotonic_time(&now);
+        if (timercmp(due, &now, <))
+            tv->tv_sec = tv->tv_usec = 0;
+        else
+            timersub(due, &now, tv);
+        pending = true;
+    }
+    if (hold_pending) {
+        CARD32 ms = hold_expiry - hold_clock;
+        if (ms & 0x80000000) ms = 0;
+        left.tv_sec = ms / 1000;
+        left.tv_usec = (ms % 1000) * 1000;
+        if (! pending || timercmp(&left, tv, <)) *tv = left;
+        pending = true;
+    }
+    return pending;
+}
+
+/**
+ * @fn    RunTimeouts(void)
+ * @brief Runs expired event loop timeouts
+ *
+ * Event loop timeouts are run from the event loop and never from signal
+ * context, so they are free to make Xlib calls and modify window lists.
+ * The monotonic clock is only read when a clock based timeout is pending.
+ */
+void EventHandler::RunTimeouts(void) {
+    struct timeval now;
+
+    if (hold_pending) CheckHold();
+    if (! flush_pending && ! keyseq) return;
+
+    monotonic_time(&now);
+    if (flush_pending && ! timercmp(&now, &flush_time, <)) {
+        flush_pending = false;
+        FlushRequests();
+    }
+    if (keyseq && ! timercmp(&now, &keyseq_time, <))
+        EndKeySequence();
+}
+
+/**
+ * @fn    CheckHold(void)
+ * @brief Runs button hold actions when hold time has passed
+ *
+ * Hold time is measured in X server time only. The hold clock is set
+ * from the timestamp of each event and advanced by the time the event
+ * loop waited for the hold timeout, no system clock is read.
+ */
+void EventHandler::CheckHold(void) {
+    if ((CARD32) (hold_clock - hold_expiry) & 0x80000000) return;
+
+    hold_pending = false;
+    if (click.Holding()) ButtonHoldAct(&hold_event);
+}
+
+/**
+ * @fn    ButtonHoldAct(XEvent *e)
+ * @brief Dispatches button hold actions
+ *
+ * @param e The ButtonPress event starting the hold
+ */
+void EventHandler::ButtonHoldAct(XEvent *e) {
+    EventDetail ed;
+
+    ed.type = ButtonHold;
+    ed.mod = e->xbutton.state;
+    ed.detail = e->xbutton.button;
+    EvAct(e, e->xbutton.window, &ed);
+}
+
+/**
+ * @fn    monotonic_time(struct timeval *tv, unsigned long ms)
+ * @brief Reads monotonic clock
+ *
+ * Used for event loop timeouts so that they are unaffected by system
+ * clock changes.
+ *
+ * @param tv Returns current monotonic time plus ms
+ * @param ms Milliseconds to add
+ */
+void monotonic_time(struct timeval *tv, unsigned long ms) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    tv->tv_sec = ts.tv_sec + ms / 1000;
+    tv->tv_usec = ts.tv_nsec / 1000 + (ms % 1000) * 1000;
+    if (tv->tv_usec >= 1000000) {
+        tv->tv_sec++;
+        tv->tv_usec -= 1000000;
+    }
+}
+
 /**
  * @fn    eventmatch(WaAction *act, EventDetail *ed)
  * @brief Event to action matcher
@@ -1015,6 +1627,7 @@ Bool eventmatch(WaAction *act, EventDetail *ed) {
     int i;
 
     if (ed->type != act->type) return false;
+    if (act->keysym != NoSymbol && ! act->detail) return false;
     if ((act->detail && ed->detail) ? (act->detail == ed->detail): true) {
         for (i = 0; i <= 12; i++)
             if (act->mod & (1 << i))
@@ -42,7 +42,30 @@ typedef struct {
 
 #define MoveResizeMask (1L << 25)
 
+#define RequestFlushDelay 100
+
 #define DoubleClick 36
+#define TripleClick 37
+#define ButtonHold  38
+#define ButtonDrag  39
+
+class ClickRecognizer {
+public:
+    ClickRecognizer(void);
+
+    unsigned int Press(XButtonEvent *, unsigned long);
+    bool Release(XButtonEvent *, unsigned long);
+    bool Motion(XMotionEvent *, int);
+    inline bool Holding(void) { return pressed && ! dragged; }
+
+    Window window;
+    unsigned int button;
+
+private:
+    Time time;
+    int count, x, y;
+    bool pressed, dragged;
+};
 
 class EventHandler {
 public:
@@ -56,6 +79,9 @@ public:
     void EvUnmapDestroy(XEvent *);
     void EvConfigureRequest(XConfigureRequestEvent *);
     void EvAct(XEvent *, Window, EventDetail *);
+    void ExecAction(WaAction *, XEvent *, Window);
+    void StartKeySequence(KeySequence *, XEvent *, Window);
+    void EndKeySequence(void);
 
     XEvent *event;
     set<int> *empty_return_mask;
@@ -64,20 +90,35 @@ public:
 
     int move_resize;
     Window focused;
+    Time last_time;
 
 private:
     void EvProperty(XPropertyEvent *);
     void EvColormap(XColormapEvent *);
+    void EvMapping(XMappingEvent *);
     void EvMapRequest(XMapRequestEvent *);
     void EvClientMessage(XEvent *, EventDetail *);
+    void EvKeySequence(XKeyEvent *);
+    bool ThrottleRequest(XEvent *);
+    void FlushRequests(void);
+    bool NextTimeout(struct timeval *);
+    void RunTimeouts(void);
+    void ButtonHoldAct(XEvent *);
+    void CheckHold(void);
 
     Waimea *waimea;
     ResourceHandler *rh;
-    Window last_click_win;
-    unsigned int last_button;
-    struct timeval last_click;
+    ClickRecognizer click;
+    KeySequence *keyseq;
+    XEvent keyseq_event;
+    Window keyseq_window;
+    struct timeval flush_time, keyseq_time;
+    Time hold_expiry, hold_clock;
+    bool flush_pending, hold_pending;
+    XEvent hold_event;
 };
 
 Bool eventmatch(WaAction *, EventDetail *);
+void monotonic_time(struct timeval *, unsigned long = 0);
 
 #endif // __EventHandler_hh
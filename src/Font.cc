@@ -24,9 +24,16 @@ using std::cerr;
 using std::cout;
 using std::endl;
 
+#include <algorithm>
+using std::upper_bound;
+
 #include "Font.hh"
 #include "Waimea.hh"
 
+#ifdef XFT
+#define LABEL_CACHE_BYTES (1024 * 1024)
+#endif // XFT
+
 /**
  * @fn    WaFont(void)
  * @brief Constructor for WaFont class
@@ -40,12 +47,74 @@ WaFont::WaFont(void) {
     xfont = NULL;
     diff = 0;
     gc = s_gc = NULL;
+    ellipsis = NULL;
 
 #ifdef XFT
     xftfont = NULL;
     color = s_color = NULL;
+    label_cache = NULL;
+    subpixel = false;
+#endif // XFT
+
+}
+
+/**
+ * @fn    WaFont(const WaFont &f)
+ * @brief Copy constructor for WaFont class
+ *
+ * @param f Font to copy
+ */
+WaFont::WaFont(const WaFont &f) {
+    ellipsis = NULL;
+    *this = f;
+}
+
+/**
+ * @fn    ~WaFont(void)
+ * @brief Destructor for WaFont class
+ *
+ * Frees ellipsis text run.
+ */
+WaFont::~WaFont(void) {
+    if (ellipsis) delete ellipsis;
+}
+
+/**
+ * @fn    operator=(const WaFont &f)
+ * @brief Copies font
+ *
+ * Copies all class members but the ellipsis text run, which refers to
+ * the font it was shaped for. The copy shapes its own ellipsis when it's
+ * first needed.
+ *
+ * @param f Font to copy
+ *
+ * @return Reference to this font
+ */
+WaFont &WaFont::operator=(const WaFont &f) {
+    if (this == &f) return *this;
+
+    xft = f.xft;
+    font = f.font;
+    gc = f.gc;
+    s_gc = f.s_gc;
+    xfont = f.xfont;
+    font_ok = f.font_ok;
+    shodow_off_x = f.shodow_off_x;
+    shodow_off_y = f.shodow_off_y;
+    diff = f.diff;
+    if (ellipsis) delete ellipsis;
+    ellipsis = NULL;
+
+#ifdef XFT
+    xftfont = f.xftfont;
+    color = f.color;
+    s_color = f.s_color;
+    label_cache = f.label_cache;
+    subpixel = f.subpixel;
 #endif // XFT
 
+    return *this;
 }
 
 /**
@@ -77,7 +146,13 @@ int WaFont::Open(Display *dpy, int screen_number, WaFont *default_font) {
             diff = xftfont->ascent - xftfont->descent;
         }
         delete [] font;
-        if (xft) return xftfont->height;
+        if (xft) {
+            int rgba;
+            subpixel = (FcPatternGetInteger(xftfont->pattern, FC_RGBA, 0,
+                                            &rgba) == FcResultMatch &&
+                        rgba != FC_RGBA_NONE && rgba != FC_RGBA_UNKNOWN);
+            return xftfont->height;
+        }
         else return xfont->ascent + xfont->descent;
     }
 #endif // XFT
@@ -108,17 +183,19 @@ int WaFont::Open(Display *dpy, int screen_number, WaFont *default_font) {
 }
 
 /**
- * @fn    AllocColor(Display *dpy, Window id, WaColor *wac, WaColor *swac)
+ * @fn    AllocColor(Display *dpy, Drawable id, WaColor *wac,
+ *                   WaColor *swac)
  * @brief Allocate colors
  *
  * Creates colors used for font rendering.
  *
  * @param dpy Display connection
- * @param id Window id used for GC creation
+ * @param id Drawable of decoration depth used for GC creation
  * @param wac Font color
  * @param wac Font shadow color
  */
-void WaFont::AllocColor(Display *dpy, Window id, WaColor *wac, WaColor *swac) {
+void WaFont::AllocColor(Display *dpy, Drawable id, WaColor *wac,
+                        WaColor *swac) {
     XGCValues gcv;
 
 #ifdef XFT
@@ -160,11 +237,11 @@ void WaFont::Draw(Display *dpy, Drawable id, XftDraw *xftdraw, int x, int y,
                   char *s, int len) {
     if (xft) {
         if (shodow_off_x || shodow_off_y)
-            XftDrawString8(xftdraw, s_color, xftfont,
-                           x + shodow_off_x, y + shodow_off_y,
-                           (unsigned char *) s, len);
-        XftDrawString8(xftdraw, color, xftfont, x, y,
-                       (unsigned char *) s, len);
+            XftDrawStringUtf8(xftdraw, s_color, xftfont,
+                              x + shodow_off_x, y + shodow_off_y,
+                              (unsigned char *) s, len);
+        XftDrawStringUtf8(xftdraw, color, xftfont, x, y,
+                          (unsigned char *) s, len);
         return;
     }
 #else // !XFT
@@ -195,10 +272,406 @@ int WaFont::Width(Display *dpy, char *s, int len) {
 #ifdef XFT
     if (xft) {
         XGlyphInfo extents;
-        XftTextExtents8(dpy, xftfont, (unsigned char *) s, len, &extents);
+        XftTextExtentsUtf8(dpy, xftfont, (unsigned char *) s, len,
+                           &extents);
         return extents.width;
     }
 #endif // XFT
 
     return XTextWidth(xfont, s, len);
 }
+
+/**
+ * @fn    Draw(Display *dpy, Drawable id, XftDraw *xftdraw, int x, int y,
+ *             WaTextRun *run, int max_width)
+ * @brief Draw text run
+ *
+ * Draws a shaped text run on drawable at a given position. If max_width
+ * is set and the run doesn't fit, the run is truncated and ellipsized
+ * using the prefix sums of glyph advances. Nothing but the ellipsis is
+ * drawn if max_width is too small for any characters, and not even the
+ * ellipsis if that doesn't fit either.
+ *
+ * @param dpy Display connection
+ * @param id Drawable used for X core font rendering
+ * @param xftdraw XftDrawable used for Xft font rendering
+ * @param x X position to draw text at
+ * @param y Y position to draw text at
+ * @param run Text run to draw
+ * @param max_width Maximum width of drawn text, 0 for no limit
+ */
+#ifdef XFT
+void WaFont::Draw(Display *dpy, Drawable id, XftDraw *xftdraw, int x, int y,
+                  WaTextRun *run, int max_width) {
+#else // !XFT
+void WaFont::Draw(Display *dpy, Drawable id, int x, int y,
+                  WaTextRun *run, int max_width) {
+#endif // XFT
+
+    int n = run->length, avail;
+    bool ellipsize = false;
+
+    if (max_width > 0 && run->Width() > max_width) {
+        if (! ellipsis) ellipsis = Shape(dpy, "...");
+        avail = max_width - ellipsis->Width();
+        n = (avail > 0)? run->Fit(avail): 0;
+        ellipsize = (avail >= 0);
+    }
+
+#ifdef XFT
+    if (! DrawRaster(dpy, id, xftdraw, x, y, run, n))
+        DrawGlyphs(dpy, id, xftdraw, x, y, run, n);
+    if (ellipsize &&
+        ! DrawRaster(dpy, id, xftdraw, x + run->advance[n], y, ellipsis,
+                     ellipsis->length))
+        DrawGlyphs(dpy, id, xftdraw, x + run->advance[n], y, ellipsis,
+                   ellipsis->length);
+#else // !XFT
+    DrawGlyphs(dpy, id, x, y, run, n);
+    if (ellipsize)
+        DrawGlyphs(dpy, id, x + run->advance[n], y, ellipsis,
+                   ellipsis->length);
+#endif // XFT
+
+}
+
+/**
+ * @fn    DrawGlyphs(Display *dpy, Drawable id, XftDraw *xftdraw, int x,
+ *                   int y, WaTextRun *run, int n)
+ * @brief Draw glyphs
+ *
+ * Draws the first n glyphs of a text run, including shadow.
+ *
+ * @param dpy Display connection
+ * @param id Drawable used for X core font rendering
+ * @param xftdraw XftDrawable used for Xft font rendering
+ * @param x X position to draw text at
+ * @param y Y position to draw text at
+ * @param run Text run to draw
+ * @param n Number of glyphs to draw
+ */
+#ifdef XFT
+void WaFont::DrawGlyphs(Display *dpy, Drawable id, XftDraw *xftdraw, int x,
+                        int y, WaTextRun *run, int n) {
+    if (xft) {
+        if (shodow_off_x || shodow_off_y)
+            XftDrawGlyphs(xftdraw, s_color, xftfont, x + shodow_off_x,
+                          y + shodow_off_y, run->glyphs, n);
+        XftDrawGlyphs(xftdraw, color, xftfont, x, y, run->glyphs, n);
+        return;
+    }
+#else // !XFT
+void WaFont::DrawGlyphs(Display *dpy, Drawable id, int x, int y,
+                        WaTextRun *run, int n) {
+#endif // XFT
+
+    if (shodow_off_x || shodow_off_y)
+        XDrawString(dpy, id, s_gc, x + shodow_off_x, y + shodow_off_y,
+                    run->chars, n);
+    XDrawString(dpy, id, gc, x, y, run->chars, n);
+}
+
+#ifdef XFT
+/**
+ * @fn    DrawRaster(Display *dpy, Drawable id, XftDraw *xftdraw, int x,
+ *                   int y, WaTextRun *run, int n)
+ * @brief Draw rasterized glyphs
+ *
+ * Composites the first n glyphs of a text run from its cached ARGB
+ * raster, which includes the text shadow. The raster is created if the
+ * run doesn't have one. Fonts with subpixel antialiasing are not
+ * rasterized, as an ARGB raster can only hold grayscale coverage.
+ *
+ * @param dpy Display connection
+ * @param id Drawable used for raster creation
+ * @param xftdraw XftDrawable to composite onto
+ * @param x X position to draw text at
+ * @param y Y position to draw text at
+ * @param run Text run to draw
+ * @param n Number of glyphs to draw
+ *
+ * @return False if text couldn't be drawn from raster, otherwise true
+ */
+bool WaFont::DrawRaster(Display *dpy, Drawable id, XftDraw *xftdraw, int x,
+                        int y, WaTextRun *run, int n) {
+    if (! xft || ! xftdraw || ! label_cache || subpixel) return false;
+    if (! n) return true;
+
+    Picture dest = XftDrawPicture(xftdraw);
+    if (dest == None) return false;
+    if (run->raster == None && ! Rasterize(dpy, id, run)) return false;
+
+    label_cache->runs.splice(label_cache->runs.begin(), label_cache->runs,
+                             run->lru);
+
+    int width = run->raster_w;
+    if (n < run->length)
+        width = wamin(width, run->advance[n] + wamax(shodow_off_x, 0) -
+                      run->raster_x);
+    if (width > 0)
+        XRenderComposite(dpy, PictOpOver, run->raster, None, dest, 0, 0,
+                         0, 0, x + run->raster_x, y + run->raster_y,
+                         width, run->raster_h);
+    return true;
+}
+
+/**
+ * @fn    Rasterize(Display *dpy, Drawable id, WaTextRun *run)
+ * @brief Rasterize text run
+ *
+ * Renders text run and its shadow into an ARGB picture and adds it to
+ * the label cache of the screen. Least recently drawn rasters are freed
+ * to keep the cache within LABEL_CACHE_BYTES.
+ *
+ * @param dpy Display connection
+ * @param id Drawable used for pixmap creation
+ * @param run Text run to rasterize
+ *
+ * @return True if raster was created, otherwise false
+ */
+bool WaFont::Rasterize(Display *dpy, Drawable id, WaTextRun *run) {
+    XRenderPictFormat *format;
+    XGlyphInfo info;
+
+    if (! (format = XRenderFindStandardFormat(dpy, PictStandardARGB32)))
+        return false;
+
+    XftGlyphExtents(dpy, xftfont, run->glyphs, run->length, &info);
+    int x0 = -info.x + wamin(shodow_off_x, 0);
+    int y0 = -info.y + wamin(shodow_off_y, 0);
+    int width = info.width + abs(shodow_off_x);
+    int height = info.height + abs(shodow_off_y);
+    if (width <= 0 || height <= 0) return false;
+
+    unsigned long bytes = width * height * 4;
+    if (bytes > LABEL_CACHE_BYTES) return false;
+    while (label_cache->bytes + bytes > LABEL_CACHE_BYTES)
+        label_cache->runs.back()->FreeRaster();
+
+    Pixmap pixmap = XCreatePixmap(dpy, id, width, height, 32);
+    Picture pict = XRenderCreatePicture(dpy, pixmap, format, 0, NULL);
+    XFreePixmap(dpy, pixmap);
+
+    XRenderColor clear = { 0, 0, 0, 0 };
+    XRenderFillRectangle(dpy, PictOpSrc, pict, &clear, 0, 0, width, height);
+
+    Picture src;
+    if (shodow_off_x || shodow_off_y) {
+        src = XRenderCreateSolidFill(dpy, &s_color->color);
+        XftGlyphRender(dpy, PictOpOver, src, xftfont, pict, 0, 0,
+                       shodow_off_x - x0, shodow_off_y - y0,
+                       run->glyphs, run->length);
+        XRenderFreePicture(dpy, src);
+    }
+    src = XRenderCreateSolidFill(dpy, &color->color);
+    XftGlyphRender(dpy, PictOpOver, src, xftfont, pict, 0, 0, -x0, -y0,
+                   run->glyphs, run->length);
+    XRenderFreePicture(dpy, src);
+
+    run->display = dpy;
+    run->raster = pict;
+    run->raster_x = x0;
+    run->raster_y = y0;
+    run->raster_w = width;
+    run->raster_h = height;
+    run->raster_bytes = bytes;
+    run->cache = label_cache;
+    label_cache->runs.push_front(run);
+    run->lru = label_cache->runs.begin();
+    label_cache->bytes += bytes;
+
+    return true;
+}
+#endif // XFT
+
+/**
+ * @fn    Shape(Display *dpy, const char *s)
+ * @brief Creates text run
+ *
+ * Decodes UTF-8 string s and maps it to glyphs of this font. Glyph
+ * advances are stored as prefix sums so text width and truncation
+ * points never need to be measured again. Invalid UTF-8 bytes, including
+ * overlong encodings, surrogates and code points above U+10FFFF, are taken
+ * as Latin-1 characters.
+ *
+ * @param dpy Display connection
+ * @param s UTF-8 string
+ *
+ * @return New text run
+ */
+WaTextRun *WaFont::Shape(Display *dpy, const char *s) {
+    const unsigned char *p = (const unsigned char *) s;
+    unsigned int *ucs = new unsigned int[strlen(s) + 1];
+    int n = 0;
+
+    static const unsigned int min[4] = { 0, 0x80, 0x800, 0x10000 };
+
+    while (*p) {
+        unsigned int c = *p, more = 0;
+        if (c >= 0xc2 && c <= 0xdf) { c &= 0x1f; more = 1; }
+        else if (c >= 0xe0 && c <= 0xef) { c &= 0x0f; more = 2; }
+        else if (c >= 0xf0 && c <= 0xf4) { c &= 0x07; more = 3; }
+
+        unsigned int i = 1;
+        for (; i <= more && (p[i] & 0xc0) == 0x80; i++)
+            c = (c << 6) | (p[i] & 0x3f);
+        if (i <= more || c < min[more] || c > 0x10ffff ||
+            (c >= 0xd800 && c <= 0xdfff)) {
+            c = *p;
+            i = 1;
+        }
+        ucs[n++] = c;
+        p += i;
+    }
+
+    WaTextRun *run = new WaTextRun(this, n);
+    run->advance[0] = 0;
+    for (int i = 0; i < n; i++) {
+        run->chars[i] = (ucs[i] < 256)? ucs[i]: '?';
+
+#ifdef XFT
+        if (xft) {
+            XGlyphInfo info;
+            run->glyphs[i] = XftCharIndex(dpy, xftfont, ucs[i]);
+            XftGlyphExtents(dpy, xftfont, &run->glyphs[i], 1, &info);
+            run->advance[i + 1] = run->advance[i] + info.xOff;
+            continue;
+        }
+#endif // XFT
+
+        run->advance[i + 1] = run->advance[i] +
+            XTextWidth(xfont, &run->chars[i], 1);
+    }
+    delete [] ucs;
+
+    return run;
+}
+
+/**
+ * @fn    WaTextRun(WaFont *f, int len)
+ * @brief Constructor for WaTextRun class
+ *
+ * Allocates glyph and advance arrays for len characters.
+ *
+ * @param f Font the run is shaped for
+ * @param len Number of characters in run
+ */
+WaTextRun::WaTextRun(WaFont *f, int len) {
+    font = f;
+    length = len;
+    advance = new int[len + 1];
+    chars = new char[len + 1];
+
+#ifdef XFT
+    glyphs = new FT_UInt[len + 1];
+    display = NULL;
+    raster = None;
+    cache = NULL;
+#endif // XFT
+
+}
+
+/**
+ * @fn    ~WaTextRun(void)
+ * @brief Destructor for WaTextRun class
+ */
+WaTextRun::~WaTextRun(void) {
+    delete [] advance;
+    delete [] chars;
+
+#ifdef XFT
+    FreeRaster();
+    delete [] glyphs;
+#endif // XFT
+
+}
+
+#ifdef XFT
+/**
+ * @fn    FreeRaster(void)
+ * @brief Frees raster
+ *
+ * Frees cached raster of text run and removes it from the label cache.
+ */
+void WaTextRun::FreeRaster(void) {
+    if (raster == None) return;
+
+    XRenderFreePicture(display, raster);
+    raster = None;
+    cache->runs.erase(lru);
+    cache->bytes -= raster_bytes;
+}
+#endif // XFT
+
+/**
+ * @fn    Fit(int width)
+ * @brief Characters fitting in width
+ *
+ * Binary searches glyph advance prefix sums.
+ *
+ * @param width Available width
+ *
+ * @return Number of characters fitting in width
+ */
+int WaTextRun::Fit(int width) {
+    if (width <= 0) return 0;
+    return (upper_bound(advance, advance + length + 1, width) - advance) - 1;
+}
+
+/**
+ * @fn    WaText(void)
+ * @brief Constructor for WaText class
+ */
+WaText::WaText(void) {
+    text = NULL;
+}
+
+/**
+ * @fn    ~WaText(void)
+ * @brief Destructor for WaText class
+ */
+WaText::~WaText(void) {
+    Set(NULL);
+}
+
+/**
+ * @fn    Set(const char *s)
+ * @brief Sets text
+ *
+ * Sets UTF-8 text. Text runs are dropped only if the text changed.
+ *
+ * @param s New text
+ */
+void WaText::Set(const char *s) {
+    if (s && text && ! strcmp(s, text)) return;
+
+    delete [] text;
+    text = NULL;
+    LISTDEL(runs);
+    if (s) {
+        text = new char[strlen(s) + 1];
+        strcpy(text, s);
+    }
+}
+
+/**
+ * @fn    Run(Display *dpy, WaFont *font)
+ * @brief Returns text run
+ *
+ * Returns text run for font, the text is shaped the first time a font is
+ * used with it.
+ *
+ * @param dpy Display connection
+ * @param font Font to get run for
+ *
+ * @return Text run
+ */
+WaTextRun *WaText::Run(Display *dpy, WaFont *font) {
+    list<WaTextRun *>::iterator it = runs.begin();
+    for (; it != runs.end(); ++it)
+        if ((*it)->font == font) return *it;
+
+    WaTextRun *run = font->Shape(dpy, (text)? text: "");
+    runs.push_back(run);
+    return run;
+}
@@ -22,11 +22,72 @@ extern "C" {
 #endif // XFT
 }
 
+#include <list>
+using std::list;
+
 class WaColor;
+class WaFont;
+class WaTextRun;
+
+#ifdef XFT
+typedef struct _LabelCache LabelCache;
+#endif // XFT
+
+class WaTextRun {
+public:
+    WaTextRun(WaFont *, int);
+    ~WaTextRun(void);
+
+    int Fit(int);
+    inline int Width(void) { return advance[length]; }
+
+    WaFont *font;
+    int length;
+    int *advance;
+    char *chars;
+
+#ifdef XFT
+    void FreeRaster(void);
+
+    FT_UInt *glyphs;
+    Display *display;
+    Picture raster;
+    int raster_x, raster_y, raster_w, raster_h;
+    unsigned long raster_bytes;
+    LabelCache *cache;
+    list<WaTextRun *>::iterator lru;
+#endif // XFT
+
+};
+
+#ifdef XFT
+struct _LabelCache {
+    list<WaTextRun *> runs;
+    unsigned long bytes;
+};
+#endif // XFT
+
+class WaText {
+public:
+    WaText(void);
+    ~WaText(void);
+
+    void Set(const char *);
+    WaTextRun *Run(Display *, WaFont *);
+
+    char *text;
+
+private:
+    list<WaTextRun *> runs;
+};
 
 class WaFont {
 public:
     WaFont(void);
+    WaFont(const WaFont &);
+    ~WaFont(void);
+
+    WaFont &operator=(const WaFont &);
 
     int Open(Display *, int, WaFont *);
     void AllocColor(Display *, Drawable id, WaColor *, WaColor * = NULL);
@@ -39,7 +100,16 @@ public:
 
               int, int, char *, int);
 
+    void Draw(Display *, Drawable,
+
+#ifdef XFT
+              XftDraw *,
+#endif // XFT
+
+              int, int, WaTextRun *, int = 0);
+
     int Width(Display *, char *, int);
+    WaTextRun *Shape(Display *, const char *);
 
     bool xft;
     const char *font;
@@ -48,10 +118,28 @@ public:
     bool font_ok;
     int shodow_off_x, shodow_off_y;
     int diff;
+    WaTextRun *ellipsis;
 
 #ifdef XFT
     XftFont *xftfont;
     XftColor *color, *s_color;
+    LabelCache *label_cache;
+    bool subpixel;
+#endif // XFT
+
+private:
+    void DrawGlyphs(Display *, Drawable,
+
+#ifdef XFT
+                    XftDraw *,
+#endif // XFT
+
+                    int, int, WaTextRun *, int);
+
+#ifdef XFT
+    bool DrawRaster(Display *, Drawable, XftDraw *, int, int, WaTextRun *,
+                    int);
+    bool Rasterize(Display *, Drawable, WaTextRun *);
 #endif // XFT
 
 };
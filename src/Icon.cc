@@ -0,0 +1,288 @@
+/**
+ * @file   Icon.cc
+ * @author David Reveman <david@waimea.org>
+ * @date   18-Oct-2026 20:48:42
+ *
+ * @brief Implementation of WaIcon class
+ *
+ * Client icons and menu item icons scaled to a fixed size and stored as
+ * server side pixmaps. Client icons are shared between all windows with
+ * identical icon data, icon files between all menu items using the same
+ * file and size.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#include <X11/Xutil.h>
+
+#ifdef    HAVE_STRING_H
+#  include <string.h>
+#endif // HAVE_STRING_H
+}
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include "Icon.hh"
+
+/**
+ * @fn    WaIcon(WaScreen *scrn, unsigned long h, unsigned int s,
+ *               unsigned int *argb)
+ * @brief Constructor for WaIcon class
+ *
+ * Creates icon pixmap and mask from size x size ARGB data. Alpha values
+ * below 50% are masked out. The icon takes ownership of the ARGB data,
+ * it's kept for comparing icons with colliding hashes.
+ *
+ * @param scrn WaScreen to create icon for
+ * @param h Hash of icon data
+ * @param s Icon width and height
+ * @param argb Icon data, allocated with new []
+ */
+WaIcon::WaIcon(WaScreen *scrn, unsigned long h, unsigned int s,
+               unsigned int *argb) {
+    Display *display = scrn->display;
+    unsigned long masks[3] = { scrn->visual->red_mask,
+                               scrn->visual->green_mask,
+                               scrn->visual->blue_mask };
+    int shifts[3], i, x, y;
+    unsigned int row = (s + 7) / 8;
+
+    wascreen = scrn;
+    hash = h;
+    size = s;
+    refs = 1;
+    file = NULL;
+    data = argb;
+
+    for (i = 0; i < 3; i++) {
+        for (shifts[i] = 0; masks[i] && ! (masks[i] & 1); shifts[i]++)
+            masks[i] >>= 1;
+    }
+
+    XImage *image = XCreateImage(display, scrn->visual, scrn->screen_depth,
+                                 ZPixmap, 0, NULL, size, size, 32, 0);
+    image->data = new char[image->bytes_per_line * size];
+    char *bits = new char[row * size];
+    memset(bits, 0, row * size);
+
+    for (y = 0; y < (signed) size; y++) {
+        for (x = 0; x < (signed) size; x++) {
+            unsigned int p = argb[y * size + x];
+            unsigned long pixel = scrn->alpha_mask;
+            for (i = 0; i < 3; i++)
+                pixel |= (((p >> (16 - i * 8)) & 0xff) * masks[i] / 0xff) <<
+                    shifts[i];
+            XPutPixel(image, x, y, pixel);
+            if ((p >> 24) >= 0x80) bits[y * row + x / 8] |= 1 << (x % 8);
+        }
+    }
+
+    pixmap = XCreatePixmap(display, wascreen->id, size, size,
+                           wascreen->screen_depth);
+    gc = XCreateGC(display, pixmap, 0, NULL);
+    XPutImage(display, pixmap, gc, image, 0, 0, 0, 0, size, size);
+    delete [] image->data;
+    image->data = NULL;
+    XDestroyImage(image);
+
+    mask = XCreateBitmapFromData(display, wascreen->id, bits, size, size);
+    delete [] bits;
+    XSetClipMask(display, gc, mask);
+}
+
+/**
+ * @fn    ~WaIcon(void)
+ * @brief Destructor for WaIcon class
+ *
+ * Frees server side resources and removes icon from icon cache.
+ */
+WaIcon::~WaIcon(void) {
+    map<unsigned long, WaIcon *>::iterator it = wascreen->icons.find(hash);
+    if (it != wascreen->icons.end() && it->second == this)
+        wascreen->icons.erase(it);
+    if (file) delete [] file;
+    delete [] data;
+    XFreeGC(wascreen->display, gc);
+    XFreePixmap(wascreen->display, pixmap);
+    XFreePixmap(wascreen->display, mask);
+}
+
+/**
+ * @fn    Get(WaScreen *ws, unsigned long *data, unsigned long len,
+ *            unsigned int size)
+ * @brief Get icon from _NET_WM_ICON data
+ *
+ * Picks the smallest icon in data not smaller than size, or the largest
+ * icon if all are smaller, and box filters it to size x size. If an icon
+ * with identical size and content already exists it is shared.
+ *
+ * @param ws WaScreen to get icon for
+ * @param data _NET_WM_ICON property data
+ * @param len Number of items in data
+ * @param size Icon width and height
+ *
+ * @return Icon with one reference held by caller, NULL if data holds no
+ *         valid icon
+ */
+WaIcon *WaIcon::Get(WaScreen *ws, unsigned long *data, unsigned long len,
+                    unsigned int size) {
+    unsigned long i, best = len, bw = 0, bh = 0;
+    unsigned int x, y;
+
+    if (! size || (ws->visual->c_class != TrueColor &&
+                   ws->visual->c_class != DirectColor))
+        return NULL;
+
+    for (i = 0; i + 2 <= len;) {
+        unsigned long w = data[i], h = data[i + 1];
+        if (! w || ! h || w > 1024 || h > 1024 || w * h > len - i - 2)
+            break;
+        if (best == len || (w >= size && (bw < size || w < bw)) ||
+            (bw < size && w > bw)) {
+            best = i;
+            bw = w;
+            bh = h;
+        }
+        i += 2 + w * h;
+    }
+    if (best == len) return NULL;
+
+    unsigned long *src = data + best + 2;
+    unsigned int *argb = new unsigned int[size * size];
+    unsigned long hash = 2166136261UL ^ size;
+    for (y = 0; y < size; y++) {
+        unsigned long y0 = y * bh / size, y1 = (y + 1) * bh / size;
+        if (y1 <= y0) y1 = y0 + 1;
+        for (x = 0; x < size; x++) {
+            unsigned long x0 = x * bw / size, x1 = (x + 1) * bw / size;
+            if (x1 <= x0) x1 = x0 + 1;
+            unsigned long sum[4] = { 0, 0, 0, 0 }, n = 0, sx, sy;
+            for (sy = y0; sy < y1; sy++)
+                for (sx = x0; sx < x1; sx++, n++)
+                    for (int c = 0; c < 4; c++)
+                        sum[c] += (src[sy * bw + sx] >> (c * 8)) & 0xff;
+            unsigned int p = 0;
+            for (int c = 0; c < 4; c++) p |= (sum[c] / n) << (c * 8);
+            argb[y * size + x] = p;
+            hash = (hash ^ p) * 16777619UL;
+        }
+    }
+
+    map<unsigned long, WaIcon *>::iterator it = ws->icons.find(hash);
+    if (it != ws->icons.end() && ! it->second->file &&
+        it->second->size == size &&
+        ! memcmp(it->second->data, argb, size * size * sizeof(*argb))) {
+        delete [] argb;
+        it->second->refs++;
+        return it->second;
+    }
+
+    WaIcon *icon = new WaIcon(ws, hash, size, argb);
+
+    // keep first icon cached if hash collides with other icon
+    if (it == ws->icons.end()) ws->icons[hash] = icon;
+
+    return icon;
+}
+
+#ifdef PIXMAP
+/**
+ * @fn    Load(WaScreen *ws, const char *file, unsigned int size)
+ * @brief Get icon from image file
+ *
+ * Decodes image file using Imlib2 and scales it to size x size. Icons are
+ * cached by file name and size, so an icon file used by several menu items
+ * is only decoded once and shares one server side pixmap.
+ *
+ * @param ws WaScreen to get icon for
+ * @param file Image file
+ * @param size Icon width and height
+ *
+ * @return Icon with one reference held by caller, NULL if file couldn't
+ *         be loaded
+ */
+WaIcon *WaIcon::Load(WaScreen *ws, const char *file, unsigned int size) {
+    unsigned long hash = 2166136261UL ^ size ^ 0x80000000UL;
+    const char *c;
+    char *__m_wastrdup_tmp;
+
+    if (! size || (ws->visual->c_class != TrueColor &&
+                   ws->visual->c_class != DirectColor))
+        return NULL;
+
+    for (c = file; *c != '\0'; c++)
+        hash = (hash ^ (unsigned char) *c) * 16777619UL;
+
+    map<unsigned long, WaIcon *>::iterator it = ws->icons.find(hash);
+    if (it != ws->icons.end() && it->second->file &&
+        it->second->size == size && ! strcmp(it->second->file, file)) {
+        it->second->refs++;
+        return it->second;
+    }
+
+    imlib_context_push(ws->imlib_context);
+    Imlib_Image image = imlib_load_image(file);
+    if (! image) {
+        WARNING << "failed loading icon `" << file << "'" << endl;
+        imlib_context_pop();
+        return NULL;
+    }
+    imlib_context_set_image(image);
+    Imlib_Image scaled =
+        imlib_create_cropped_scaled_image(0, 0, imlib_image_get_width(),
+                                          imlib_image_get_height(),
+                                          size, size);
+    imlib_free_image();
+    if (! scaled) {
+        imlib_context_pop();
+        return NULL;
+    }
+    imlib_context_set_image(scaled);
+    DATA32 *data = imlib_image_get_data_for_reading_only();
+    unsigned int *argb = new unsigned int[size * size];
+    unsigned int alpha = (imlib_image_has_alpha())? 0: 0xff000000;
+    for (unsigned int i = 0; i < size * size; i++)
+        argb[i] = data[i] | alpha;
+    imlib_free_image();
+    imlib_context_pop();
+
+    WaIcon *icon = new WaIcon(ws, hash, size, argb);
+    icon->file = __m_wastrdup(file);
+
+    // keep first icon cached if hash collides with other icon
+    if (it == ws->icons.end()) ws->icons[hash] = icon;
+
+    return icon;
+}
+#endif // PIXMAP
+
+/**
+ * @fn    Release(void)
+ * @brief Release icon reference
+ *
+ * Icon is deleted when last reference is released.
+ */
+void WaIcon::Release(void) {
+    if (--refs == 0) delete this;
+}
+
+/**
+ * @fn    Draw(Drawable d, int x, int y)
+ * @brief Draw icon
+ *
+ * @param d Drawable to draw icon on
+ * @param x X position to draw icon at
+ * @param y Y position to draw icon at
+ */
+void WaIcon::Draw(Drawable d, int x, int y) {
+    XSetClipOrigin(wascreen->display, gc, x, y);
+    XCopyArea(wascreen->display, pixmap, d, gc, 0, 0, size, size, x, y);
+}
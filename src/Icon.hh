@@ -0,0 +1,50 @@
+/**
+ * @file   Icon.hh
+ * @author David Reveman <david@waimea.org>
+ * @date   18-Oct-2026 20:48:42
+ *
+ * @brief Definition of WaIcon class
+ *
+ * Function declarations and variable definitions for WaIcon class.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifndef __Icon_hh
+#define __Icon_hh
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+class WaIcon;
+
+#include "Screen.hh"
+
+class WaIcon {
+public:
+    WaIcon(WaScreen *, unsigned long, unsigned int, unsigned int *);
+    virtual ~WaIcon(void);
+
+    static WaIcon *Get(WaScreen *, unsigned long *, unsigned long,
+                       unsigned int);
+
+#ifdef PIXMAP
+    static WaIcon *Load(WaScreen *, const char *, unsigned int);
+#endif // PIXMAP
+
+    void Release(void);
+    void Draw(Drawable, int, int);
+
+    WaScreen *wascreen;
+    unsigned long hash;
+    unsigned int size;
+    int refs;
+    char *file;
+    unsigned int *data;
+    Pixmap pixmap, mask;
+    GC gc;
+};
+
+#endif // __Icon_hh
@@ -148,8 +148,6 @@ WaImage::~WaImage(void) {
 Pixmap WaImage::render(WaTexture *texture) {
     if (texture->getTexture() & WaImage_ParentRelative)
         return ParentRelative;
-    else if (texture->getTexture() & WaImage_Solid)
-        return render_solid(texture);
     else if (texture->getTexture() & WaImage_Gradient)
         return render_gradient(texture);
 
@@ -181,104 +179,6 @@ Pixmap WaImage::render_pixmap(WaTexture *texture) {
 #endif // PIXMAP
 
 
-Pixmap WaImage::render_solid(WaTexture *texture) {
-    Pixmap pixmap = XCreatePixmap(control->getDisplay(),
-                                  control->getDrawable(), width,
-                                  height, control->getDepth());
-    if (pixmap == None) {
-        WARNING << "error creating pixmap" << endl;
-        return None;
-    }
-
-    XGCValues gcv;
-    GC gc, hgc, lgc;
-
-    gcv.foreground = texture->getColor()->getPixel();
-    gcv.fill_style = FillSolid;
-    gc = XCreateGC(control->getDisplay(), pixmap,
-                   GCForeground | GCFillStyle, &gcv);
-
-    gcv.foreground = texture->getHiColor()->getPixel();
-    hgc = XCreateGC(control->getDisplay(), pixmap,
-                    GCForeground, &gcv);
-
-    gcv.foreground = texture->getLoColor()->getPixel();
-    lgc = XCreateGC(control->getDisplay(), pixmap,
-                    GCForeground, &gcv);
-
-    XFillRectangle(control->getDisplay(), pixmap, gc, 0, 0,
-                   width, height);
-
-#ifdef    INTERLACE
-    if (texture->getTexture() & WaImage_Interlaced) {
-        gcv.foreground = texture->getColorTo()->getPixel();
-        GC igc = XCreateGC(control->getDisplay(), pixmap,
-                           GCForeground, &gcv);
-
-        register unsigned int i = 0;
-        for (; i < height; i += 2)
-            XDrawLine(control->getDisplay(), pixmap, igc,
-                      0, i, width, i);
-
-        XFreeGC(control->getDisplay(), igc);
-    }
-#endif // INTERLACE
-
-
-    if (texture->getTexture() & WaImage_Bevel1) {
-        if (texture->getTexture() & WaImage_Raised) {
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, height - 1, width - 1, height - 1);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      width - 1, height - 1, width - 1, 0);
-
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, 0, width - 1, 0);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, height - 1, 0, 0);
-        } else if (texture->getTexture() & WaImage_Sunken) {
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, height - 1, width - 1, height - 1);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      width - 1, height - 1, width - 1, 0);
-
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, 0, width - 1, 0);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, height - 1, 0, 0);
-        }
-    } else if (texture->getTexture() & WaImage_Bevel2) {
-        if (texture->getTexture() & WaImage_Raised) {
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, height - 3, width - 3, height - 3);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      width - 3, height - 3, width - 3, 1);
-
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, 1, width - 3, 1);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, height - 3, 1, 1);
-        } else if (texture->getTexture() & WaImage_Sunken) {
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, height - 3, width - 3, height - 3);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      width - 3, height - 3, width - 3, 1);
-
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, 1, width - 3, 1);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, height - 3, 1, 1);
-        }
-    }
-
-    XFreeGC(control->getDisplay(), gc);
-    XFreeGC(control->getDisplay(), hgc);
-    XFreeGC(control->getDisplay(), lgc);
-
-    return pixmap;
-}
-
-
 Pixmap WaImage::render_gradient(WaTexture *texture) {
     int inverted = 0;
 
@@ -314,7 +214,7 @@ Pixmap WaImage::render_gradient(WaTexture *texture) {
 
     if (inverted) invert();
 
-    Pixmap pixmap = renderPixmap();
+    Pixmap pixmap = renderPixmap(texture);
 
     return pixmap;
 }
@@ -337,7 +237,7 @@ XImage *WaImage::renderXImage(void) {
     register unsigned int x, y, dithx, dithy, r, g, b, o, er, eg, eb, offset;
 
     unsigned char *pixel_data = d, *ppixel_data = d;
-    unsigned long pixel;
+    unsigned long pixel, alpha_mask = control->getAlphaMask();
 
     o = image->bits_per_pixel + ((image->byte_order == MSBFirst) ? 1 : 0);
 
@@ -389,7 +289,7 @@ XImage *WaImage::renderXImage(void) {
                             (b < blue_table[255])) b++;
 
                         pixel = (r << red_offset) | (g << green_offset) |
-                            (b << blue_offset);
+                            (b << blue_offset) | alpha_mask;
 
                         switch (o) {
                             case  8: //  8bpp
@@ -595,7 +495,7 @@ XImage *WaImage::renderXImage(void) {
                         b = blue_table[blue[offset]];
 
                         pixel = (r << red_offset) | (g << green_offset) |
-                            (b << blue_offset);
+                            (b << blue_offset) | alpha_mask;
 
                         switch (o) {
                             case  8: //  8bpp
@@ -670,7 +570,7 @@ XImage *WaImage::renderXImage(void) {
 }
 
 
-Pixmap WaImage::renderPixmap(void) {
+Pixmap WaImage::renderPixmap(WaTexture *texture) {
     Pixmap pixmap =
         XCreatePixmap(control->getDisplay(),
                       control->getDrawable(), width, height,
@@ -692,11 +592,14 @@ Pixmap WaImage::renderPixmap(void) {
         return None;
     }
 
-    XPutImage(control->getDisplay(), pixmap,
-              DefaultGC(control->getDisplay(),
-                        control->getScreen()),
+    XPutImage(control->getDisplay(), pixmap, control->getCopyGC(),
               image, 0, 0, 0, 0, width, height);
 
+    if (texture && control->addSharedImage(texture, width, height,
+                                           image->data,
+                                           image->bytes_per_line))
+        image->data = NULL;
+
     if (image->data) {
         delete [] image->data;
         image->data = NULL;
@@ -1844,28 +1747,52 @@ void WaImage::cdgradient(void) {
 }
 
 
+unsigned int *WaImageControl::grad_xbuffer = NULL;
+unsigned int *WaImageControl::grad_ybuffer = NULL;
+unsigned int WaImageControl::grad_buffer_width = 0;
+unsigned int WaImageControl::grad_buffer_height = 0;
+unsigned long *WaImageControl::sqrt_table = NULL;
+int WaImageControl::instances = 0;
+list<WaImageControl::SharedImage *> WaImageControl::shared_images;
+
 WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
                                int _cpc, unsigned long cmax) {
     display       = dpy;
     screen_number = scrn->screen_number;
-    screen_depth  = DefaultDepth(display, screen_number);
+    screen_depth  = scrn->screen_depth;
     window        = RootWindow(display, screen_number);
-    colormap      = DefaultColormap(display, screen_number);
+    colormap      = scrn->colormap;
     visual        = DefaultVisual(display, screen_number);
+    alpha_mask    = scrn->alpha_mask;
     wascreen      = scrn;
 
+    if (scrn->argb_visual) {
+        XVisualInfo templ, *vinfo;
+        int n;
+
+        // screen visual belongs to other display connection
+        templ.visualid = XVisualIDFromVisual(scrn->visual);
+        templ.screen = screen_number;
+        if ((vinfo = XGetVisualInfo(display, VisualIDMask | VisualScreenMask,
+                                    &templ, &n))) {
+            visual = vinfo->visual;
+            XFree(vinfo);
+        }
+    }
+
     setDither(_dither);
     setColorsPerChannel(_cpc);
 
     cache_max = cmax;
 
+#ifdef RENDER
+    xrender_cache_size = 0;
+#endif // RENDER
+
     colors = (XColor *) 0;
     ncolors = 0;
 
-    grad_xbuffer = grad_ybuffer = (unsigned int *) 0;
-    grad_buffer_width = grad_buffer_height = 0;
-
-    sqrt_table = (unsigned long *) 0;
+    instances++;
 
     int count;
     XPixmapFormatValues *pmv = XListPixmapFormats(display,
@@ -2112,19 +2039,42 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
             quit(1);
     }
     cache = new list<Cache *>;
+
+    // GCs must match depth of decoration pixmaps, which isn't the root
+    // window depth when ARGB visual is used
+    gc_pixmap = XCreatePixmap(display, window, 1, 1, screen_depth);
+    copy_gc = XCreateGC(display, gc_pixmap, 0, NULL);
+
+    XGCValues gcv;
+    gcv.fill_style = FillTiled;
+    tile_gc = XCreateGC(display, gc_pixmap, GCFillStyle, &gcv);
 }
 
 
 WaImageControl::~WaImageControl(void) {
     XSync(wascreen->display, false);
-    if (sqrt_table) {
-        delete [] sqrt_table;
-    }
-    if (grad_xbuffer) {
-        delete [] grad_xbuffer;
+    list<SharedImage *>::iterator sit = shared_images.begin();
+    while (sit != shared_images.end()) {
+        if ((*sit)->owner == this) {
+            delete [] (*sit)->data;
+            delete *sit;
+            sit = shared_images.erase(sit);
+        } else ++sit;
     }
-    if (grad_ybuffer) {
-        delete [] grad_ybuffer;
+    if (--instances == 0) {
+        if (sqrt_table) {
+            delete [] sqrt_table;
+            sqrt_table = NULL;
+        }
+        if (grad_xbuffer) {
+            delete [] grad_xbuffer;
+            grad_xbuffer = NULL;
+        }
+        if (grad_ybuffer) {
+            delete [] grad_ybuffer;
+            grad_ybuffer = NULL;
+        }
+        grad_buffer_width = grad_buffer_height = 0;
     }
     if (colors) {
         unsigned long *pixels = new unsigned long [ncolors];
@@ -2147,6 +2097,21 @@ WaImageControl::~WaImageControl(void) {
         }
     }
     delete cache;
+
+#ifdef RENDER
+    while (! xrender_cache.empty()) {
+        XFreePixmap(display, xrender_cache.back()->pixmap);
+        delete xrender_cache.back();
+        xrender_cache.pop_back();
+    }
+#endif // RENDER
+
+    map<unsigned long, GC>::iterator git = solid_gcs.begin();
+    for (; git != solid_gcs.end(); ++git)
+        XFreeGC(display, git->second);
+    XFreeGC(display, tile_gc);
+    XFreeGC(display, copy_gc);
+    XFreePixmap(display, gc_pixmap);
     XSync(wascreen->display, false);
     XSync(wascreen->pdisplay, false);
 }
@@ -2185,9 +2150,37 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
     Pixmap retp;
     if (texture->getTexture() & WaImage_ParentRelative) return ParentRelative;
 
+    if (texture->getTexture() & WaImage_Solid) {
+
+#ifdef RENDER
+        return xrender(None, width, height, texture, parent, src_x, src_y,
+                       dest);
+#else // !RENDER
+        return None;
+#endif // RENDER
+
+    }
+
     XSync(wascreen->display, false);
 
-    Pixmap pixmap = searchCache(width, height, texture->getTexture(),
+    // flat horizontal and vertical gradients are constant along one axis,
+    // they are rendered as strips and tiled to the requested size
+    unsigned int w = width, h = height;
+    if ((texture->getTexture() & WaImage_Gradient) &&
+        (texture->getTexture() & WaImage_Flat)) {
+        unsigned int period = (doDither())? 8: 1;
+        if (texture->getTexture() & WaImage_Vertical)
+            w = wamin(width, period);
+        else if (texture->getTexture() & WaImage_Horizontal)
+            h = wamin(height, period);
+
+#ifdef    INTERLACE
+        if (texture->getTexture() & WaImage_Interlaced) h = height;
+#endif // INTERLACE
+
+    }
+
+    Pixmap pixmap = searchCache(w, h, texture->getTexture(),
                                 texture->getColor(), texture->getColorTo());
     if (pixmap) {
 
@@ -2203,8 +2196,10 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
         return retp;
     }
 
-    WaImage image(this, width, height);
-    pixmap = image.render(texture);
+    if (! (pixmap = searchSharedImage(w, h, texture))) {
+        WaImage image(this, w, h);
+        pixmap = image.render(texture);
+    }
 
 #ifdef PIXMAP
     if (texture->getTexture() & WaImage_Pixmap) {
@@ -2226,8 +2221,8 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
         Cache *tmp = new Cache;
 
         tmp->pixmap = pixmap;
-        tmp->width = width;
-        tmp->height = height;
+        tmp->width = w;
+        tmp->height = h;
         tmp->count = 1;
         tmp->texture = texture->getTexture();
         tmp->pixel1 = texture->getColor()->getPixel();
@@ -2259,6 +2254,144 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
 }
 
 
+/**
+ * @fn    sameFormat(WaImageControl *ic)
+ * @brief Checks if image data can be shared
+ *
+ * Image data rendered by one image control can be used by another if both
+ * use TrueColor visuals with identical pixel layout and render with the
+ * same dithering settings, pixel values are then independent of screen
+ * and colormap.
+ *
+ * @param ic Image control to compare with
+ *
+ * @return True if image data can be shared, otherwise false
+ */
+bool WaImageControl::sameFormat(WaImageControl *ic) {
+    return (ic->visual->c_class == TrueColor &&
+            visual->c_class == TrueColor &&
+            ic->visual->red_mask == visual->red_mask &&
+            ic->visual->green_mask == visual->green_mask &&
+            ic->visual->blue_mask == visual->blue_mask &&
+            ic->screen_depth == screen_depth &&
+            ic->bits_per_pixel == bits_per_pixel &&
+            ic->dither == dither &&
+            ic->colors_per_channel == colors_per_channel);
+}
+
+/**
+ * @fn    colorKey(WaColor *color)
+ * @brief Shared image key for color
+ *
+ * Pixel values of the same color differ between colormaps of different
+ * screens, so shared images are matched on RGB values.
+ *
+ * @param color Color to return key for
+ *
+ * @return RGB values of color packed into one value
+ */
+static unsigned long colorKey(WaColor *color) {
+    return ((unsigned long) color->getRed() << 16) |
+        ((unsigned long) color->getGreen() << 8) |
+        (unsigned long) color->getBlue();
+}
+
+/**
+ * @fn    searchSharedImage(unsigned int width, unsigned int height,
+ *                          WaTexture *texture)
+ * @brief Finds image rendered for another screen
+ *
+ * Searches image data rendered by image controls of other screens with
+ * matching visual. If found, the data is uploaded to a new pixmap on this
+ * screen so that the image doesn't have to be rendered again.
+ *
+ * @param width Image width
+ * @param height Image height
+ * @param texture Texture of image
+ *
+ * @return Pixmap with image, None if no shared image was found
+ */
+Pixmap WaImageControl::searchSharedImage(unsigned int width,
+                                         unsigned int height,
+                                         WaTexture *texture) {
+    if (! (texture->getTexture() & WaImage_Gradient)) return None;
+
+    unsigned long c1 = colorKey(texture->getColor());
+    unsigned long c2 = colorKey(texture->getColorTo());
+    list<SharedImage *>::iterator it = shared_images.begin();
+    for (; it != shared_images.end(); ++it) {
+        SharedImage *si = *it;
+        if (si->width == width && si->height == height &&
+            si->texture == texture->getTexture() &&
+            si->color1 == c1 && si->color2 == c2 &&
+            (si->owner == this || sameFormat(si->owner))) {
+            Pixmap pixmap = XCreatePixmap(display, window, width, height,
+                                          screen_depth);
+            if (pixmap == None) return None;
+            XImage *image = XCreateImage(display, visual, screen_depth,
+                                         ZPixmap, 0, si->data, width, height,
+                                         32, si->bytes_per_line);
+            if (! image) {
+                XFreePixmap(display, pixmap);
+                return None;
+            }
+            XPutImage(display, pixmap, copy_gc, image, 0, 0, 0, 0, width,
+                      height);
+            image->data = NULL;
+            XDestroyImage(image);
+
+            shared_images.erase(it);
+            shared_images.push_front(si);
+            return pixmap;
+        }
+    }
+    return None;
+}
+
+/**
+ * @fn    addSharedImage(WaTexture *texture, unsigned int width,
+ *                       unsigned int height, char *data,
+ *                       unsigned int bytes_per_line)
+ * @brief Makes rendered image available to other screens
+ *
+ * Stores rendered image data for use by image controls of other screens.
+ * Image data is only stored when more than one screen is managed and
+ * the visual allows sharing. At most SharedImageMax images are kept, least
+ * recently used images are dropped first.
+ *
+ * @param texture Texture of image
+ * @param width Image width
+ * @param height Image height
+ * @param data Image data, ownership is taken if true is returned
+ * @param bytes_per_line Length of image data lines
+ *
+ * @return True if data was stored, otherwise false
+ */
+bool WaImageControl::addSharedImage(WaTexture *texture, unsigned int width,
+                                    unsigned int height, char *data,
+                                    unsigned int bytes_per_line) {
+    if (instances < 2 && ScreenCount(display) < 2) return false;
+    if (visual->c_class != TrueColor) return false;
+
+    SharedImage *si = new SharedImage;
+    si->owner = this;
+    si->texture = texture->getTexture();
+    si->color1 = colorKey(texture->getColor());
+    si->color2 = colorKey(texture->getColorTo());
+    si->width = width;
+    si->height = height;
+    si->bytes_per_line = bytes_per_line;
+    si->data = data;
+    shared_images.push_front(si);
+
+    if (shared_images.size() > SharedImageMax) {
+        delete [] shared_images.back()->data;
+        delete shared_images.back();
+        shared_images.pop_back();
+    }
+    return true;
+}
+
 void WaImageControl::removeImage(Pixmap pixmap) {
     if (pixmap) {
         list<Cache *>::iterator it = cache->begin();
@@ -2276,6 +2409,14 @@ void WaImageControl::removeImage(Pixmap pixmap) {
     }
 }
 
+// rendered images can be smaller than the requested size, they are always
+// tiled when used
+void WaImageControl::fillImage(Drawable d, Pixmap pixmap, unsigned int width,
+                               unsigned int height) {
+    XSetTile(display, tile_gc, pixmap);
+    XFillRectangle(display, d, tile_gc, 0, 0, width, height);
+}
+
 unsigned long WaImageControl::getColor(const char *colorname,
                                        unsigned short *r, unsigned short *g,
                                        unsigned short *b) {
@@ -2291,7 +2432,7 @@ unsigned long WaImageControl::getColor(const char *colorname,
     *g = color.green;
     *b = color.blue;
 
-    return color.pixel;
+    return color.pixel | alpha_mask;
 }
 
 unsigned long WaImageControl::getColor(const char *colorname) {
@@ -2303,7 +2444,7 @@ unsigned long WaImageControl::getColor(const char *colorname) {
     else if (! XAllocColor(display, colormap, &color))
         WARNING << "color alloc error: \"" << colorname << "\"" << endl;
 
-    return color.pixel;
+    return color.pixel | alpha_mask;
 }
 
 void WaImageControl::getColorTables(unsigned char **rmt, unsigned char **gmt,
@@ -2498,6 +2639,71 @@ void WaImageControl::parseColor(WaColor *color, char *c) {
     }
 }
 
+GC WaImageControl::getSolidGC(unsigned long pixel) {
+    map<unsigned long, GC>::iterator it = solid_gcs.find(pixel);
+    if (it != solid_gcs.end()) return it->second;
+
+    XGCValues gcv;
+    gcv.foreground = pixel;
+    GC gc = XCreateGC(display, gc_pixmap, GCForeground, &gcv);
+    solid_gcs.insert(make_pair(pixel, gc));
+
+    return gc;
+}
+
+// solid textures are never rendered to pixmaps, the color is used as
+// window background and bevel and interlace lines are drawn on top with
+// one XDrawSegments request per color
+void WaImageControl::drawSolid(Drawable d, unsigned int width,
+                               unsigned int height, WaTexture *texture) {
+    unsigned long t = texture->getTexture();
+    if (! (t & WaImage_Solid) || width < 2 || height < 2) return;
+
+#ifdef    INTERLACE
+    if (t & WaImage_Interlaced) {
+        int n = 0;
+        XSegment *seg = new XSegment[(height + 1) / 2];
+        for (unsigned int i = 0; i < height; i += 2, n++) {
+            seg[n].x1 = 0;
+            seg[n].y1 = seg[n].y2 = i;
+            seg[n].x2 = width;
+        }
+        XDrawSegments(display, d,
+                      getSolidGC(texture->getColorTo()->getPixel()), seg, n);
+        delete [] seg;
+    }
+#endif // INTERLACE
+
+    short l, r, top, bottom;
+    if (t & WaImage_Bevel1) {
+        l = top = 0;
+        r = width - 1;
+        bottom = height - 1;
+    } else if (t & WaImage_Bevel2) {
+        if (width < 4 || height < 4) return;
+        l = top = 1;
+        r = width - 3;
+        bottom = height - 3;
+    } else
+        return;
+
+    GC gc1, gc2;
+    if (t & WaImage_Raised) {
+        gc1 = getSolidGC(texture->getLoColor()->getPixel());
+        gc2 = getSolidGC(texture->getHiColor()->getPixel());
+    } else if (t & WaImage_Sunken) {
+        gc1 = getSolidGC(texture->getHiColor()->getPixel());
+        gc2 = getSolidGC(texture->getLoColor()->getPixel());
+    } else
+        return;
+
+    XSegment br[2] = { { l, bottom, r, bottom }, { r, bottom, r, top } };
+    XSegment tl[2] = { { l, top, r, top }, { l, bottom, l, top } };
+
+    XDrawSegments(display, d, gc1, br, 2);
+    XDrawSegments(display, d, gc2, tl, 2);
+}
+
 void WaImageControl::timeout(void) {
     list<Cache *>::iterator it = cache->begin();
     for (; it != cache->end(); ++it) {
@@ -2512,6 +2718,33 @@ void WaImageControl::timeout(void) {
 }
 
 #ifdef RENDER
+/**
+ * @fn    xrender(Pixmap p, unsigned int width, unsigned int height,
+ *                WaTexture *texture, Pixmap parent, unsigned int src_x,
+ *                unsigned int src_y, Pixmap dest)
+ * @brief Render translucent texture
+ *
+ * Composites texture pixmap p over the area of root window background
+ * pixmap parent at src_x, src_y and stores the result in dest. Results are
+ * cached by texture, size, root window position and background pixmap in
+ * an LRU bounded by XRenderCacheSize bytes of pixmap memory, so rendering
+ * the same area against a background that was used before, e.g. when
+ * switching back to a desktop, is a single copy. With an ARGB visual
+ * the texture is stored in dest with texture opacity as alpha and parent
+ * is not used. Without a usable background pixmap dest is filled with the
+ * opaque texture.
+ *
+ * @param p Texture pixmap, None for solid textures
+ * @param width Width of area
+ * @param height Height of area
+ * @param texture Texture to render
+ * @param parent Root window background pixmap
+ * @param src_x X position of area on root window
+ * @param src_y Y position of area on root window
+ * @param dest Destination pixmap
+ *
+ * @return Pixmap holding result, dest if dest isn't None
+ */
 Pixmap WaImageControl::xrender(Pixmap p, unsigned int width,
                                unsigned int height, WaTexture *texture,
                                Pixmap parent, unsigned int src_x,
@@ -2520,33 +2753,84 @@ Pixmap WaImageControl::xrender(Pixmap p, unsigned int width,
     Picture src_pict, dest_pict;
     XRenderPictFormat *format;
 
-    if ((! texture->getOpacity()) || parent == None || dest == None)
-        return p;
+    if ((! texture->getOpacity()) || dest == None) return p;
 
     XSync(wascreen->display, false);
 
+    if (wascreen->argb_visual) {
+        format = XRenderFindVisualFormat(display, visual);
+        dest_pict = XRenderCreatePicture(display, (Drawable) dest, format,
+                                         0, 0);
+        if (texture->getOpacity() == 255) {
+            XRenderColor clear = { 0, 0, 0, 0 };
+            XRenderFillRectangle(display, PictOpSrc, dest_pict, &clear, 0, 0,
+                                 width, height);
+        } else {
+            if (p == None)
+                src_pict = texture->getSolidPicture();
+            else {
+                XRenderPictureAttributes pa;
+                pa.repeat = True;
+                src_pict = XRenderCreatePicture(display, (Drawable) p,
+                                                format, CPRepeat, &pa);
+            }
+            XRenderComposite(display, PictOpSrc, src_pict,
+                             texture->getAlphaPicture(), dest_pict, 0, 0, 0,
+                             0, 0, 0, width, height);
+            if (p != None) XRenderFreePicture(display, src_pict);
+            else drawSolid(dest, width, height, texture);
+        }
+        XRenderFreePicture(display, dest_pict);
+        XSync(wascreen->display, false);
+        XSync(wascreen->pdisplay, false);
+        return dest;
+    }
+
     GC gc;
     unsigned int w, h;
-    if (! validatedrawable(parent, &w, &h)) {
-        setXRootPMapId(false);
-        gc = DefaultGC(display, screen_number);
-        XCopyArea(display, p, dest, gc, 0, 0, width, height, 0, 0);
+    if (parent == None || ! validatedrawable(parent, &w, &h)) {
+        if (parent != None) setXRootPMapId(false);
+        if (p == None) {
+            XFillRectangle(display, dest,
+                           getSolidGC(texture->getColor()->getPixel()), 0, 0,
+                           width, height);
+            drawSolid(dest, width, height, texture);
+        } else
+            fillImage(dest, p, width, height);
         XSync(wascreen->display, false);
         XSync(wascreen->pdisplay, false);
-        return p;
+        return dest;
+    }
+
+    XRenderCache *xc;
+    list<XRenderCache *>::iterator it = xrender_cache.begin();
+    if (texture->getOpacity() != 255) {
+        for (; it != xrender_cache.end(); ++it) {
+            xc = *it;
+            if (xc->texture == texture && xc->parent == parent &&
+                xc->width == width && xc->height == height &&
+                xc->x == src_x && xc->y == src_y) {
+                xrender_cache.erase(it);
+                xrender_cache.push_back(xc);
+                XCopyArea(display, xc->pixmap, dest, copy_gc, 0, 0, width,
+                          height, 0, 0);
+                XSync(wascreen->display, false);
+                XSync(wascreen->pdisplay, false);
+                return dest;
+            }
+        }
     }
 
     if (w < (unsigned int) wascreen->width ||
         h < (unsigned int) wascreen->height) {
-        gc = XCreateGC(display, wascreen->id, 0, NULL);
+        gc = XCreateGC(display, gc_pixmap, 0, NULL);
         XSetTile(display, gc, parent);
         XSetTSOrigin(display, gc, w - (src_x % w), h - (src_y % h));
         XSetFillStyle(display, gc, FillTiled);
         XFillRectangle(display, dest, gc, 0, 0, width, height);
         XFreeGC(display, gc);
     } else {
-        gc = DefaultGC(display, screen_number);
-        XCopyArea(display, parent, dest, gc, src_x, src_y, width,
+        XCopyArea(display, parent, dest, copy_gc, src_x, src_y, width,
                   height, 0, 0);
     }
 
@@ -2559,14 +2843,46 @@ Pixmap WaImageControl::xrender(Pixmap p, unsigned int width,
     format = XRenderFindVisualFormat(display, visual);
     if (p == None)
         src_pict = texture->getSolidPicture();
-    else
-        src_pict = XRenderCreatePicture(display, (Drawable) p, format, 0, 0);
+    else {
+        XRenderPictureAttributes pa;
+        pa.repeat = True;
+        src_pict = XRenderCreatePicture(display, (Drawable) p, format,
+                                        CPRepeat, &pa);
+    }
     dest_pict = XRenderCreatePicture(display, (Drawable) dest, format, 0, 0);
     XRenderComposite(display, PictOpOver, src_pict,
                      texture->getAlphaPicture(), dest_pict, 0, 0, 0, 0, 0, 0,
                      width, height);
     if (p != None) XRenderFreePicture(display, src_pict);
+    else drawSolid(dest, width, height, texture);
     XRenderFreePicture(display, dest_pict);
+
+    unsigned long size = (unsigned long) width * height *
+        ((bits_per_pixel + 7) / 8);
+    if (size <= XRenderCacheSize) {
+        while (xrender_cache_size + size > XRenderCacheSize) {
+            xc = xrender_cache.front();
+            xrender_cache.pop_front();
+            xrender_cache_size -= xc->size;
+            XFreePixmap(display, xc->pixmap);
+            delete xc;
+        }
+        xc = new XRenderCache;
+        xc->parent = parent;
+        xc->texture = texture;
+        xc->width = width;
+        xc->height = height;
+        xc->x = src_x;
+        xc->y = src_y;
+        xc->size = size;
+        xc->pixmap = XCreatePixmap(display, wascreen->id, width, height,
+                                   screen_depth);
+        XCopyArea(display, dest, xc->pixmap, copy_gc, 0, 0, width, height,
+                  0, 0);
+        xrender_cache.push_back(xc);
+        xrender_cache_size += size;
+    }
+
     XSync(wascreen->display, false);
     XSync(wascreen->pdisplay, false);
     return dest;
@@ -2574,4 +2890,27 @@ Pixmap WaImageControl::xrender(Pixmap p, unsigned int width,
 
 void WaImageControl::setXRootPMapId(bool hrp) { have_root_pmap = hrp; }
 
+/**
+ * @fn    removeXRender(Pixmap parent)
+ * @brief Remove cached translucency results
+ *
+ * Frees all cached results rendered against root window background pixmap
+ * parent. Called when the background pixmap is no longer in use or its
+ * content may have changed.
+ *
+ * @param parent Root window background pixmap
+ */
+void WaImageControl::removeXRender(Pixmap parent) {
+    list<XRenderCache *>::iterator it = xrender_cache.begin();
+    while (it != xrender_cache.end()) {
+        if ((*it)->parent == parent) {
+            xrender_cache_size -= (*it)->size;
+            XFreePixmap(display, (*it)->pixmap);
+            delete *it;
+            it = xrender_cache.erase(it);
+        } else
+            ++it;
+    }
+}
+
 #endif // RENDER
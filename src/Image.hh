@@ -37,6 +37,9 @@ extern "C" {
 #include <list>
 using std::list;
 
+#include <map>
+using std::map;
+
 class WaImage;
 class WaImageControl;
 
@@ -204,7 +207,7 @@ private:
 
 
 protected:
-    Pixmap renderPixmap(void);
+    Pixmap renderPixmap(WaTexture * = NULL);
 
     XImage *renderXImage(void);
 
@@ -225,7 +228,6 @@ public:
     ~WaImage(void);
 
     Pixmap render(WaTexture *);
-    Pixmap render_solid(WaTexture *);
     Pixmap render_gradient(WaTexture *);
     Display *display;
     unsigned int bpp;
@@ -238,6 +240,9 @@ public:
 
 #include "Screen.hh"
 
+#define XRenderCacheSize (8 * 1024 * 1024)
+#define SharedImageMax  64
+
 class WaImageControl {
 private:
     bool dither;
@@ -252,11 +257,26 @@ private:
     int colors_per_channel, ncolors, screen_number, screen_depth,
         bits_per_pixel, red_offset, green_offset, blue_offset,
         red_bits, green_bits, blue_bits;
+    unsigned long alpha_mask;
     unsigned char red_color_table[256], green_color_table[256],
         blue_color_table[256];
-    unsigned int *grad_xbuffer, *grad_ybuffer, grad_buffer_width,
+    unsigned long cache_max;
+
+    // sqrt table and gradient buffers are shared by all image controls
+    static unsigned int *grad_xbuffer, *grad_ybuffer, grad_buffer_width,
         grad_buffer_height;
-    unsigned long *sqrt_table, cache_max;
+    static unsigned long *sqrt_table;
+    static int instances;
+
+    // rendered image data is shared by image controls of matching visuals
+    typedef struct SharedImage {
+        WaImageControl *owner;
+        unsigned long texture, color1, color2;
+        unsigned int width, height, bytes_per_line;
+        char *data;
+    } SharedImage;
+
+    static list<SharedImage *> shared_images;
 
     typedef struct Cache {
         Pixmap pixmap;
@@ -266,10 +286,27 @@ private:
     } Cache;
 
     list<Cache *> *cache;
+    map<unsigned long, GC> solid_gcs;
+    Pixmap gc_pixmap;
+    GC tile_gc, copy_gc;
+
+#ifdef RENDER
+    typedef struct XRenderCache {
+        Pixmap parent, pixmap;
+        WaTexture *texture;
+        unsigned int width, height, x, y;
+        unsigned long size;
+    } XRenderCache;
+
+    list<XRenderCache *> xrender_cache;
+    unsigned long xrender_cache_size;
+#endif // RENDER
 
 protected:
     Pixmap searchCache(unsigned int, unsigned int, unsigned long, WaColor *,
                        WaColor *);
+    Pixmap searchSharedImage(unsigned int, unsigned int, WaTexture *);
+    bool sameFormat(WaImageControl *);
 
 public:
     WaImageControl(Display *, WaScreen *, bool = false, int = 4,
@@ -283,19 +320,24 @@ public:
     inline Visual *getVisual(void) { return visual; }
     inline Colormap getColormap(void) { return colormap; }
     inline const Window &getDrawable(void) const { return window; }
+    inline GC getCopyGC(void) { return copy_gc; }
     inline const int &getBitsPerPixel(void) const { return bits_per_pixel; }
     inline const int &getDepth(void) const { return screen_depth; }
+    inline unsigned long getAlphaMask(void) { return alpha_mask; }
     inline const int &getColorsPerChannel(void) const
         { return colors_per_channel; }
     unsigned long getColor(const char *);
     unsigned long getColor(const char *, unsigned short *, unsigned short *,
                            unsigned short *);
     unsigned long getSqrt(unsigned int);
+    bool addSharedImage(WaTexture *, unsigned int, unsigned int, char *,
+                        unsigned int);
     Pixmap renderImage(unsigned int, unsigned int, WaTexture *,
                        Pixmap = None, unsigned int = 0, unsigned int = 0,
                        Pixmap = None);
     void installRootColormap(void);
     void removeImage(Pixmap);
+    void fillImage(Drawable, Pixmap, unsigned int, unsigned int);
     void getColorTables(unsigned char **, unsigned char **, unsigned char **,
                         int *, int *, int *, int *, int *, int *);
     void getXColorTable(XColor **, int *);
@@ -305,6 +347,8 @@ public:
     void setColorsPerChannel(int);
     void parseTexture(WaTexture *, char *);
     void parseColor(WaColor *, char * = 0);
+    GC getSolidGC(unsigned long);
+    void drawSolid(Drawable, unsigned int, unsigned int, WaTexture *);
 
     virtual void timeout(void);
 
@@ -313,6 +357,7 @@ public:
                    Pixmap = None, unsigned int = 0, unsigned int = 0,
                    Pixmap = None);
     void setXRootPMapId(bool);
+    void removeXRender(Pixmap);
 #endif // RENDER
 
 };
@@ -11,6 +11,10 @@
  * three types can perform the same actions. Possible actions are execution of
  * program, call to function and mapping of menu as submenu.
  *
+ * Generated menus are built in-process from directory listings and desktop
+ * entry files. They are cached and only regenerated when inotify reports
+ * a change in one of the directories they were generated from.
+ *
  * Copyright (C) David Reveman. All rights reserved.
  *
  */
@@ -31,9 +35,28 @@ extern "C" {
 #ifdef    HAVE_STRING_H
 #  include <string.h>
 #endif // HAVE_STRING_H
+
+#ifdef    HAVE_UNISTD_H
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+#ifdef    HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif // HAVE_SYS_STAT_H
+
+#ifdef    HAVE_DIRENT_H
+#  include <dirent.h>
+#endif // HAVE_DIRENT_H
+
+#ifdef    HAVE_SYS_INOTIFY_H
+#  include <sys/inotify.h>
+#endif // HAVE_SYS_INOTIFY_H
 }
 
 #include "Menu.hh"
+#include "Icon.hh"
+#include "Outline.hh"
 
 #include <iostream>
 using std::cerr;
@@ -56,7 +79,7 @@ WaMenu::WaMenu(const char *n) : WindowObject((Window) 0, MenuType) {
     height = 0;
     width = 0;
     mapped = has_focus = built = dynamic = dynamic_root =
-        ignore = db = false;
+        ignore = db = icons = false;
     ext_type = NoExtMenuType;
     root_menu = NULL;
     root_item = NULL;
@@ -105,6 +128,11 @@ void WaMenu::AddItem(WaMenuItem *item) {
     item->menu = this;
     item->hilited = false;
     item_list.push_back(item);
+
+#ifdef PIXMAP
+    if (item->icon_file) icons = true;
+#endif // PIXMAP
+
 }
 
 /**
@@ -216,7 +244,10 @@ void WaMenu::Build(WaScreen *screen) {
         else wafont = &wascreen->mstyle.wa_f_font;
 
         char *l = (*it)->e_label? (*it)->e_label: (*it)->label;
-        (*it)->width = wafont->Width(display, l, strlen(l)) + 20;
+        (*it)->text.Set(l);
+        (*it)->width = (*it)->text.Run(display, wafont)->Width() + 20;
+        if (icons && (*it)->type != MenuTitleType)
+            (*it)->width += wascreen->mstyle.item_height;
 
         if ((*it)->type == MenuCBItemType) {
             l = (*it)->e_label2? (*it)->e_label2: (*it)->label2;
@@ -251,10 +282,14 @@ void WaMenu::Build(WaScreen *screen) {
     if (width > (wascreen->width / 2)) width = wascreen->width / 2;
 
     WaTexture *texture = &wascreen->mstyle.back_frame;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         pbackframe = None;
         backframe_pixel = texture->getColor()->getPixel();
-        if (wascreen->config.db) db = true;
+
+        // items have parent relative backgrounds so bevels need a pixmap
+        if (wascreen->config.db ||
+            texture->getTexture() != (WaImage_Flat | WaImage_Solid))
+            db = true;
     } else {
         pbackframe = ic->renderImage(width, height, texture);
         if (wascreen->config.db && pbackframe != ParentRelative)
@@ -267,31 +302,38 @@ void WaMenu::Build(WaScreen *screen) {
 #endif // RENDER
 
     texture = &wascreen->mstyle.title;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         ptitle = None;
         title_pixel = texture->getColor()->getPixel();
     } else
         ptitle = ic->renderImage(width, t_height, texture);
 
     texture = &wascreen->mstyle.hilite;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         philite = None;
         hilite_pixel = texture->getColor()->getPixel();
     } else
         philite = ic->renderImage(width, f_height, texture);
 
+    int back_mask = CWBackPixmap;
     attrib_set.background_pixmap = ParentRelative;
     attrib_set.border_pixel = wascreen->mstyle.border_color.getPixel();
     attrib_set.colormap = wascreen->colormap;
     attrib_set.override_redirect = true;
     attrib_set.event_mask = NoEventMask;
 
+    // root window background can't be inherited by ARGB window
+    if (wascreen->argb_visual) {
+        back_mask = CWBackPixel;
+        attrib_set.background_pixel = 0;
+    }
+
     if (! built) {
         frame = XCreateWindow(display, wascreen->id, 0, 0, width, height,
                               wascreen->mstyle.border_width,
                               wascreen->screen_depth,
                               CopyFromParent, wascreen->visual,
-                              CWOverrideRedirect | CWBackPixmap |
+                              CWOverrideRedirect | back_mask |
                               CWEventMask | CWColormap | CWBorderPixel,
                               &attrib_set);
     } else XResizeWindow(display, frame, width, height);
@@ -372,9 +414,8 @@ void WaMenu::Render(void) {
                 Pixmap p_tmp;
                 p_tmp = XCreatePixmap(display, wascreen->id, width, height,
                                       wascreen->screen_depth);
-                GC gc = DefaultGC(display, wascreen->screen_number);
-                XCopyArea(display, pixmap, p_tmp, gc, 0, 0, width,
-                          height, 0, 0);
+                XCopyArea(display, pixmap, p_tmp, wascreen->copy_gc, 0, 0,
+                          width, height, 0, 0);
                 list<WaMenuItem *>::iterator it = item_list.begin();
                 for (; it != item_list.end(); ++it) {
                     (*it)->Draw(p_tmp, true, (*it)->dy);
@@ -393,17 +434,13 @@ void WaMenu::Render(void) {
             if (db) {
                 p_tmp = XCreatePixmap(display, wascreen->id, width,
                                       height, wascreen->screen_depth);
-                if (pbackframe) {
-                    GC gc = DefaultGC(display, wascreen->screen_number);
-                    XCopyArea(display, pbackframe, p_tmp, gc, 0, 0, width,
-                              height, 0, 0);
-                } else {
-                    XGCValues values;
-                    values.foreground = backframe_pixel;
-                    GC gc = XCreateGC(display, wascreen->id, GCForeground,
-                                      &values);
-                    XFillRectangle(display, p_tmp, gc, 0, 0, width, height);
-                    XFreeGC(display, gc);
+                if (pbackframe)
+                    wascreen->ic->fillImage(p_tmp, pbackframe, width, height);
+                else {
+                    XFillRectangle(display, p_tmp,
+                                   wascreen->ic->getSolidGC(backframe_pixel),
+                                   0, 0, width, height);
+                    wascreen->ic->drawSolid(p_tmp, width, height, texture);
                 }
                 list<WaMenuItem *>::iterator it = item_list.begin();
                 for (; it != item_list.end(); ++it) {
@@ -456,6 +493,11 @@ void WaMenu::Map(int mx, int my) {
     y = my;
     mapped = true;
     has_focus = false;
+
+#ifdef PIXMAP
+    LoadIcons();
+#endif // PIXMAP
+
     XMoveWindow(display, frame, x, y);
     Render();
     XMapSubwindows(display, frame);
@@ -463,6 +505,32 @@ void WaMenu::Map(int mx, int my) {
     XUngrabPointer(display, CurrentTime);
 }
 
+#ifdef PIXMAP
+/**
+ * @fn    LoadIcons(void)
+ * @brief Loads menu item icons
+ *
+ * Loads icon files of menu items that haven't been loaded yet. Called when
+ * menu is mapped, so icons of menus that are never mapped are never
+ * decoded. Icon files that can't be loaded are dropped and not tried again.
+ */
+void WaMenu::LoadIcons(void) {
+    if (! icons) return;
+
+    list<WaMenuItem *>::iterator it = item_list.begin();
+    for (; it != item_list.end(); ++it) {
+        if ((*it)->icon_file && ! (*it)->icon) {
+            (*it)->icon = WaIcon::Load(wascreen, (*it)->icon_file,
+                                       wascreen->mstyle.item_height - 2);
+            if (! (*it)->icon) {
+                delete [] (*it)->icon_file;
+                (*it)->icon_file = NULL;
+            }
+        }
+    }
+}
+#endif // PIXMAP
+
 /**
  * @fn    ReMap(int mx, int my)
  * @brief Remaps menu
@@ -490,6 +558,11 @@ void WaMenu::ReMap(int mx, int my) {
     y = my;
     mapped = true;
     has_focus = false;
+
+#ifdef PIXMAP
+    LoadIcons();
+#endif // PIXMAP
+
     XMoveWindow(display, frame, x, y);
     Render();
     XMapSubwindows(display, frame);
@@ -522,7 +595,7 @@ void WaMenu::Move(int dx, int dy, bool render) {
     XMoveWindow(display, frame, x, y);
 
 #ifdef RENDER
-    if (render) {
+    if (render && ! wascreen->argb_visual) {
         render_if_opacity = true;
         Render();
         render_if_opacity = false;
@@ -659,105 +732,60 @@ void WaMenu::UnmapTree(void) {
  * @fn    CreateOutline(void)
  * @brief Creates outline
  *
- * Creates four windows used for displaying an outline when doing
- * non opaque moving and resizing of the menu.
+ * Starts displaying the screen outline when doing non opaque moving of
+ * the menu.
  */
 void WaMenu::CreateOutline(void) {
-    XSetWindowAttributes attrib_set;
-
-    int create_mask = CWOverrideRedirect | CWBackPixel | CWEventMask |
-        CWColormap;
-    attrib_set.background_pixel = wascreen->wstyle.outline_color.getPixel();
-    attrib_set.colormap = wascreen->colormap;
-    attrib_set.override_redirect = true;
-    attrib_set.event_mask = NoEventMask;
-
-    o_west = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                           wascreen->screen_number, CopyFromParent,
-                           wascreen->visual, create_mask, &attrib_set);
-    o_east = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                           wascreen->screen_number, CopyFromParent,
-                           wascreen->visual, create_mask, &attrib_set);
-    o_north = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                            wascreen->screen_number, CopyFromParent,
-                            wascreen->visual, create_mask, &attrib_set);
-    o_south = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                            wascreen->screen_number, CopyFromParent,
-                            wascreen->visual, create_mask, &attrib_set);
-    wascreen->aot_stacking_list.push_front(o_west);
-    wascreen->aot_stacking_list.push_front(o_east);
-    wascreen->aot_stacking_list.push_front(o_north);
-    wascreen->aot_stacking_list.push_front(o_south);
-    XMapWindow(display, o_west);
-    XMapWindow(display, o_east);
-    XMapWindow(display, o_north);
-    XMapWindow(display, o_south);
-
-    wascreen->RestackWindows(o_west);
-
-    list<WaMenuItem *>::iterator it = item_list.begin();
-    for (; it != item_list.end(); ++it) {
-        if (((*it)->func_mask & MenuSubMask) && (*it)->submenu &&
-            (*it)->submenu->root_menu && (*it)->submenu->mapped) {
-            (*it)->submenu->CreateOutline();
-        }
-    }
+    wascreen->outline->Map();
 }
 
 /**
  * @fn    DestroyOutline(void)
- * @brief Destroys window outline
+ * @brief Destroys menu outline
  *
- * Destorys the four outline windows.
+ * Hides the screen outline.
  */
 void WaMenu::DestroyOutline(void) {
-    list<WaMenuItem *>::iterator it = item_list.begin();
-    for (; it != item_list.end(); ++it) {
-        if (((*it)->func_mask & MenuSubMask) && (*it)->submenu &&
-            (*it)->submenu->root_menu && (*it)->submenu->mapped) {
-            (*it)->submenu->DestroyOutline();
-        }
-    }
-    wascreen->aot_stacking_list.remove(o_west);
-    wascreen->aot_stacking_list.remove(o_east);
-    wascreen->aot_stacking_list.remove(o_north);
-    wascreen->aot_stacking_list.remove(o_south);
-    XDestroyWindow(display, o_west);
-    XDestroyWindow(display, o_east);
-    XDestroyWindow(display, o_north);
-    XDestroyWindow(display, o_south);
+    wascreen->outline->Unmap();
 }
 
 /**
  * @fn    DrawOutline(int dx, int dy)
  * @brief Draws menu outline
  *
- * Recursive function for drawing a outline for a menu tree. Draws outline for
- * all menu in the current menu subtree that are still linked. This function
- * is used for none opaque moving.
+ * Draws outline for all menus in the current menu subtree that are still
+ * linked. This function is used for none opaque moving.
  *
  * @param dx X position relative to menu position to draw outline
  * @param dy Y position relative to menu position to draw outline
  */
 void WaMenu::DrawOutline(int dx, int dy) {
+    wascreen->outline->Clear();
+    AddOutline(dx, dy);
+    wascreen->outline->Draw();
+}
+
+/**
+ * @fn    AddOutline(int dx, int dy)
+ * @brief Adds menu outline
+ *
+ * Recursive function that adds outline frames for all menus in the current
+ * menu subtree that are still linked.
+ *
+ * @param dx X position relative to menu position to draw outline
+ * @param dy Y position relative to menu position to draw outline
+ */
+void WaMenu::AddOutline(int dx, int dy) {
     list<WaMenuItem *>::iterator it = item_list.begin();
     for (; it != item_list.end(); ++it) {
         if (((*it)->func_mask & MenuSubMask) && (*it)->submenu &&
             (*it)->submenu->root_menu && (*it)->submenu->mapped) {
-            (*it)->submenu->DrawOutline(dx, dy);
+            (*it)->submenu->AddOutline(dx, dy);
         }
     }
     int bw = wascreen->mstyle.border_width;
-    XResizeWindow(display, o_west, bw, bw * 2 + height);
-    XResizeWindow(display, o_east, bw, bw * 2 + height);
-    XResizeWindow(display, o_north, width + bw * 2, bw);
-    XResizeWindow(display, o_south, width + bw * 2, bw);
-    int xx = x + dx;
-    int yy = y + dy;
-    XMoveWindow(display, o_west, xx, yy);
-    XMoveWindow(display, o_east, xx + width + bw, yy);
-    XMoveWindow(display, o_north, xx, yy);
-    XMoveWindow(display, o_south, xx, yy + bw + height);
+    wascreen->outline->AddFrame(x + dx, y + dy, width + bw * 2,
+                                height + bw * 2, bw);
 }
 
 /**
@@ -828,6 +856,8 @@ WaMenuItem::WaMenuItem(const char *s) : WindowObject(0, 0) {
     move_resize = sdyn = sdyn1 = sdyn2 = db = false;
     e_label = e_label1 = e_label2 = NULL;
     e_sub = e_sub1 = e_sub2 = NULL;
+    icon_file = NULL;
+    icon = NULL;
 
 #ifdef XFT
     xftdraw = (Drawable) 0;
@@ -859,6 +889,8 @@ WaMenuItem::~WaMenuItem(void) {
     if (e_label2) delete [] e_label2;
     if (e_sub1) delete [] e_sub1;
     if (e_sub2) delete [] e_sub2;
+    if (icon_file) delete [] icon_file;
+    if (icon) icon->Release();
 
     menu->item_list.remove(this);
 
@@ -1019,7 +1051,11 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
         XClearWindow(menu->display, id);
         return;
     }
-    if (! drawable) XClearWindow(menu->display, id);
+    if (! drawable) {
+        XClearWindow(menu->display, id);
+        if (type == MenuTitleType || hilited)
+            menu->wascreen->ic->drawSolid(id, menu->width, height, texture);
+    }
 
     Pixmap p_tmp = 0;
     if (drawable && !frame) {
@@ -1027,18 +1063,14 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
                               menu->width, height,
                               menu->wascreen->screen_depth);
         if (drawable == (Drawable) 2) {
-            XGCValues values;
-            values.foreground = texture->getColor()->getPixel();
-            GC gc = XCreateGC(menu->display, menu->wascreen->id,
-                              GCForeground, &values);
-            XFillRectangle(menu->display, p_tmp, gc, 0, 0, menu->width,
-                           height);
-            XFreeGC(menu->display, gc);
-        } else {
-            GC gc = DefaultGC(menu->display, menu->wascreen->screen_number);
-            XCopyArea(menu->display, drawable, p_tmp, gc, 0, 0, menu->width,
-                      height, 0, 0);
-        }
+            WaImageControl *ic = menu->wascreen->ic;
+            XFillRectangle(menu->display, p_tmp,
+                           ic->getSolidGC(texture->getColor()->getPixel()),
+                           0, 0, menu->width, height);
+            ic->drawSolid(p_tmp, menu->width, height, texture);
+        } else
+            menu->wascreen->ic->fillImage(p_tmp, drawable, menu->width,
+                                          height);
     }
     if (frame) p_tmp = drawable;
 
@@ -1047,7 +1079,19 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
     if (e_label) l = e_label;
     else l = label;
 
-    width = wafont_b->Width(menu->display, l, strlen(l)) + 20;
+    text.Set(l);
+    WaTextRun *run = text.Run(menu->display, wafont);
+    width = run->Width() + 20;
+
+    int icon_w = 0;
+    WaIcon *draw_icon = NULL;
+    if (menu->icons && type != MenuTitleType) {
+        icon_w = menu->wascreen->mstyle.item_height;
+        width += icon_w;
+        WaWindow *ww = (WaWindow *) menu->waimea->FindWin(wf, WindowType);
+        if (icon) draw_icon = icon;
+        else if (ww) draw_icon = ww->icon;
+    }
 
     if (type == MenuTitleType)
         justify = menu->wascreen->mstyle.t_justify;
@@ -1073,6 +1117,11 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
             else x += (menu->width - menu->extra_width) - (width - 10);
     }
 
+    if (draw_icon)
+        draw_icon->Draw((drawable)? p_tmp: id, x,
+                        org_y + (height - (signed) draw_icon->size) / 2);
+    x += icon_w;
+
     if (type == MenuTitleType) y += menu->wascreen->mstyle.t_y_pos;
     else y += menu->wascreen->mstyle.f_y_pos;
 
@@ -1087,7 +1136,10 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
                  xftdraw,
 #endif // XFT
 
-                 x, y, l, strlen(l));
+                 x, y, run, menu->width - x - ((type == MenuSubType)?
+                                               menu->bullet_width + 5:
+                                               (type == MenuCBItemType)?
+                                               menu->cb_width + 5: 5));
 
     if (type == MenuSubType) {
         y = org_y + menu->wascreen->mstyle.b_y_pos;
@@ -1211,6 +1263,7 @@ void WaMenuItem::MapSubmenu(XEvent *, WaAction *, bool focus, bool only) {
     }
     if (submenu->mapped) return;
 
+    submenu->Update();
     if (submenu->ext_type == TaskExtMenuType)
         ((WindowMenu *) submenu)->Build(menu->wascreen);
     else if (submenu->ext_type == MergeExtMenuType)
@@ -1276,6 +1329,7 @@ void WaMenuItem::RemapSubmenu(XEvent *, WaAction *, bool focus) {
             return;
     }
 
+    submenu->Update();
     if (submenu->ext_type == TaskExtMenuType)
         ((WindowMenu *) submenu)->Build(menu->wascreen);
     else if (submenu->ext_type == MergeExtMenuType)
@@ -1336,7 +1390,7 @@ void WaMenuItem::Exec(XEvent *, WaAction *) {
     if (! in_window) return;
     if (! (func_mask & MenuExecMask)) return;
 
-    waexec(exec, menu->wascreen->displaystring);
+    waexec(exec, menu->wascreen);
 }
 
 /**
@@ -1782,12 +1836,14 @@ void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
     list<WaAction *>::iterator it = acts->begin();
     for (; it != acts->end(); ++it) {
         if (eventmatch(*it, ed)) {
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+            if ((*it)->seq)
+                menu->waimea->eh->StartKeySequence((*it)->seq, e, id);
+            else if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
                 Interrupt *i = new Interrupt(*it, e, id);
                 menu->waimea->timer->AddInterrupt(i);
             } else {
                 if ((*it)->exec)
-                    waexec((*it)->exec, menu->wascreen->displaystring);
+                    waexec((*it)->exec, menu->wascreen);
                 else
                     ((*this).*((*it)->menufunc))(e, *it);
             }
@@ -1937,6 +1993,7 @@ WindowMenu::WindowMenu(void) : WaMenu("__windowlist__") {
     WaMenuItem *m;
 
     ext_type = TaskExtMenuType;
+    icons = true;
     m = new WaMenuItem("Window List");
     m->type = MenuTitleType;
     AddItem(m);
@@ -2072,6 +2129,541 @@ void MergeMenu::Build(WaScreen *wascreen, Window ign) {
     WaMenu::Build(wascreen);
 }
 
+/**
+ * @fn    GeneratedMenu(const char *n, WaScreen *ws, const char *t) :
+ *        WaMenu(n)
+ * @brief Constructor for GeneratedMenu class
+ *
+ * Creates a GeneratedMenu object, base class for menus generated
+ * in-process. The menu is registered with waimea so that it receives
+ * inotify invalidations.
+ *
+ * @param n Menu name
+ * @param ws WaScreen menu belongs to
+ * @param t Menu title
+ */
+GeneratedMenu::GeneratedMenu(const char *n, WaScreen *ws, const char *t) :
+    WaMenu(n) {
+    char *__m_wastrdup_tmp;
+
+    wascreen = ws;
+    waimea = ws->waimea;
+    title = __m_wastrdup(t);
+    stale = false;
+    waimea->generated_menus.push_back(this);
+}
+
+/**
+ * @fn    ~GeneratedMenu(void)
+ * @brief Destructor for GeneratedMenu class
+ *
+ * Unregisters menu from waimea. Inotify watches are left in place as the
+ * same directory can be watched by other menus.
+ */
+GeneratedMenu::~GeneratedMenu(void) {
+    waimea->generated_menus.remove(this);
+    delete [] title;
+}
+
+/**
+ * @fn    Update(void)
+ * @brief Regenerates menu if stale
+ *
+ * Reads pending inotify events and regenerates menu items if any of the
+ * watched directories have changed. Mapped menus are left untouched.
+ */
+void GeneratedMenu::Update(void) {
+    waimea->ReadInotify();
+    if (! stale || mapped) return;
+
+    list<WaMenuItem *>::iterator it = item_list.begin();
+    for (; it != item_list.end(); ++it)
+        if ((*it)->submenu && (*it)->submenu->root_item == *it)
+            (*it)->submenu->root_item = NULL;
+    LISTDELITEMS(item_list);
+
+    stale = false;
+    Generate();
+    Build(wascreen);
+}
+
+/**
+ * @fn    Watch(const char *dir)
+ * @brief Watch directory for changes
+ *
+ * Adds an inotify watch for directory. If the directory can't be watched
+ * the menu is regenerated each time it's mapped.
+ *
+ * @param dir Directory to watch
+ */
+void GeneratedMenu::Watch(const char *dir) {
+
+#ifdef HAVE_SYS_INOTIFY_H
+    int wd;
+
+    if (waimea->inotify_fd >= 0) {
+        wd = inotify_add_watch(waimea->inotify_fd, dir, IN_CREATE |
+                               IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                               IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF |
+                               IN_MOVE_SELF);
+        if (wd >= 0) {
+            watches.remove(wd);
+            watches.push_back(wd);
+            return;
+        }
+    }
+#endif // HAVE_SYS_INOTIFY_H
+
+    stale = true;
+}
+
+/**
+ * @fn    Invalidate(int wd, bool removed)
+ * @brief Mark menu as stale
+ *
+ * Marks menu as stale if wd is one of the menus watches. A wd of -1 means
+ * that events have been lost and always marks menu as stale. A removed
+ * watch is dropped from the menus watches, as inotify can reuse its
+ * descriptor for another directory. The watch is added again when the
+ * menu is regenerated.
+ *
+ * @param wd Watch descriptor from inotify event
+ * @param removed True if watch has been removed by inotify
+ */
+void GeneratedMenu::Invalidate(int wd, bool removed) {
+    if (wd == -1) {
+        stale = true;
+        return;
+    }
+    list<int>::iterator it = watches.begin();
+    for (; it != watches.end(); ++it)
+        if (*it == wd) {
+            stale = true;
+            if (removed) watches.erase(it);
+            return;
+        }
+}
+
+/**
+ * @fn    item_label_cmp(WaMenuItem *a, WaMenuItem *b)
+ * @brief Menu item sort order
+ *
+ * @param a First menu item
+ * @param b Second menu item
+ *
+ * @return True if label of a sorts before label of b
+ */
+static bool item_label_cmp(WaMenuItem *a, WaMenuItem *b) {
+    return strcasecmp(a->label, b->label) < 0;
+}
+
+/**
+ * @fn    shell_quote(const char *s)
+ * @brief Quote string for shell
+ *
+ * @param s String to quote
+ *
+ * @return String enclosed in single quotes, to be deleted by caller
+ */
+static char *shell_quote(const char *s) {
+    char *q, *d;
+    int n = 3;
+
+    for (q = (char *) s; *q != '\0'; q++) n += (*q == '\'')? 4: 1;
+    d = q = new char[n];
+    *d++ = '\'';
+    for (; *s != '\0'; s++) {
+        if (*s == '\'') {
+            memcpy(d, "'\\''", 4);
+            d += 4;
+        } else
+            *d++ = *s;
+    }
+    *d++ = '\'';
+    *d = '\0';
+    return q;
+}
+
+/**
+ * @fn    DirectoryMenu(const char *n, WaScreen *ws, const char *p,
+ *                      const char *c) : GeneratedMenu(n, ws, p)
+ * @brief Constructor for DirectoryMenu class
+ *
+ * Creates a DirectoryMenu object, a menu listing the contents of a
+ * directory. Subdirectories are listed as submenus.
+ *
+ * @param n Menu name
+ * @param ws WaScreen menu belongs to
+ * @param p Directory to list
+ * @param c Command to run on selected file, NULL if only executable files
+ *          should be listed and run
+ */
+DirectoryMenu::DirectoryMenu(const char *n, WaScreen *ws, const char *p,
+                             const char *c) :
+    GeneratedMenu(n, ws, (strrchr(p, '/') && strrchr(p, '/')[1])?
+                  strrchr(p, '/') + 1: p) {
+    char *__m_wastrdup_tmp;
+
+    path = __m_wastrdup(p);
+    command = (c)? __m_wastrdup(c): NULL;
+}
+
+/**
+ * @fn    ~DirectoryMenu(void)
+ * @brief Destructor for DirectoryMenu class
+ */
+DirectoryMenu::~DirectoryMenu(void) {
+    delete [] path;
+    if (command) delete [] command;
+}
+
+/**
+ * @fn    Generate(void)
+ * @brief Generates DirectoryMenu items
+ *
+ * Lists directory, subdirectories first, sorted by name. Hidden files
+ * are skipped.
+ */
+void DirectoryMenu::Generate(void) {
+    list<WaMenuItem *> dirs, files;
+    struct dirent *ent;
+    struct stat st;
+    WaMenuItem *m;
+    DIR *dir;
+    char *file, *quoted;
+    int len = strlen(path);
+
+    m = new WaMenuItem(title);
+    m->type = MenuTitleType;
+    AddItem(m);
+
+    if (! (dir = opendir(path))) {
+        WARNING << "failed opening directory `" << path << "'" << endl;
+        stale = true;
+        return;
+    }
+    Watch(path);
+
+    while ((ent = readdir(dir))) {
+        if (*ent->d_name == '.') continue;
+        file = new char[len + strlen(ent->d_name) + 2];
+        sprintf(file, (len && path[len - 1] == '/')? "%s%s": "%s/%s", path,
+                ent->d_name);
+        if (stat(file, &st)) {
+            delete [] file;
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (! strchr(file, '"')) {
+                m = new WaMenuItem(ent->d_name);
+                m->type = MenuSubType;
+                m->sub = m->sub1 = new char[strlen(file) + 28 +
+                                            ((command)? strlen(command): 0)];
+                sprintf(m->sub, "directory!@directory \"%s\"%s%s", file,
+                        (command)? " ": "", (command)? command: "");
+                m->func_mask |= MenuSubMask;
+                m->func_mask1 |= MenuSubMask;
+                dirs.push_back(m);
+            }
+        }
+        else if (command || (S_ISREG(st.st_mode) && ! access(file, X_OK))) {
+            m = new WaMenuItem(ent->d_name);
+            m->type = MenuItemType;
+            quoted = shell_quote(file);
+            if (command) {
+                m->exec = m->exec1 = new char[strlen(command) +
+                                              strlen(quoted) + 2];
+                sprintf(m->exec, "%s %s", command, quoted);
+                delete [] quoted;
+            } else
+                m->exec = m->exec1 = quoted;
+            m->func_mask |= MenuExecMask;
+            m->func_mask1 |= MenuExecMask;
+            files.push_back(m);
+        }
+        delete [] file;
+    }
+    closedir(dir);
+
+    dirs.sort(item_label_cmp);
+    files.sort(item_label_cmp);
+    list<WaMenuItem *>::iterator it = dirs.begin();
+    for (; it != dirs.end(); ++it) AddItem(*it);
+    for (it = files.begin(); it != files.end(); ++it) AddItem(*it);
+}
+
+/**
+ * Main categories from the XDG desktop menu specification. An application
+ * is put in the first category it matches, applications matching no
+ * category are put in Other.
+ */
+static const struct {
+    const char *name, *label;
+} app_categories[] = {
+    { "AudioVideo", "Multimedia" },
+    { "Audio", "Multimedia" },
+    { "Video", "Multimedia" },
+    { "Development", "Development" },
+    { "Education", "Education" },
+    { "Game", "Games" },
+    { "Graphics", "Graphics" },
+    { "Network", "Internet" },
+    { "Office", "Office" },
+    { "Science", "Science" },
+    { "Settings", "Settings" },
+    { "System", "System" },
+    { "Utility", "Accessories" },
+    { "Other", "Other" },
+    { NULL, NULL }
+};
+
+/**
+ * @fn    app_category(const char *categories)
+ * @brief Find main category
+ *
+ * Audio and Video are merged into AudioVideo.
+ *
+ * @param categories Semicolon separated list of categories
+ *
+ * @return Index in app_categories of main category
+ */
+static int app_category(const char *categories) {
+    int i, len;
+    const char *c;
+
+    for (i = 0; app_categories[i + 1].name; i++) {
+        len = strlen(app_categories[i].name);
+        for (c = categories; c && *c != '\0'; c = strchr(c, ';')) {
+            if (*c == ';') c++;
+            if (! strncmp(c, app_categories[i].name, len) &&
+                (c[len] == ';' || c[len] == '\0'))
+                return (i < 3)? 0: i;
+        }
+    }
+    return i;
+}
+
+/**
+ * @fn    app_category_label(const char *name)
+ * @brief Get label for category
+ *
+ * @param name Category name
+ *
+ * @return Label for category, name if category isn't a main category
+ */
+static const char *app_category_label(const char *name) {
+    for (int i = 0; app_categories[i].name; i++)
+        if (! strcmp(app_categories[i].name, name))
+            return app_categories[i].label;
+    return name;
+}
+
+/**
+ * @fn    read_desktop_entry(const char *file, char **name, char **exec,
+ *                           char **icon, int *category)
+ * @brief Read desktop entry file
+ *
+ * Reads name, command line, icon and main category from the Desktop
+ * Entry group of a desktop entry file. Field codes are removed from the
+ * command line.
+ *
+ * @param file Desktop entry file
+ * @param name Returns name, to be deleted by caller
+ * @param exec Returns command line, to be deleted by caller
+ * @param icon Returns icon, NULL if no icon, to be deleted by caller
+ * @param category Returns index in app_categories of main category
+ *
+ * @return True if file describes an application that should be displayed
+ */
+static bool read_desktop_entry(const char *file, char **name, char **exec,
+                               char **icon, int *category) {
+    char line[1024], *value, *s, *d;
+    char *categories = NULL;
+    bool group = false, app = false, hidden = false;
+    char *__m_wastrdup_tmp;
+    FILE *fd;
+
+    *name = *exec = *icon = NULL;
+    if (! (fd = fopen(file, "r"))) return false;
+    while (fgets(line, 1024, fd)) {
+        for (s = line + strlen(line); s > line && (s[-1] == '\n' ||
+                                                   s[-1] == '\r'); s--);
+        *s = '\0';
+        if (*line == '[') {
+            group = ! strcmp(line, "[Desktop Entry]");
+            continue;
+        }
+        if (! group || ! (value = strchr(line, '='))) continue;
+        for (s = value; s > line && (s[-1] == ' ' || s[-1] == '\t'); s--);
+        *s = '\0';
+        for (value++; *value == ' ' || *value == '\t'; value++);
+        if (! strcmp(line, "Name") && ! *name)
+            *name = __m_wastrdup(value);
+        else if (! strcmp(line, "Exec") && ! *exec)
+            *exec = __m_wastrdup(value);
+        else if (! strcmp(line, "Icon") && ! *icon)
+            *icon = __m_wastrdup(value);
+        else if (! strcmp(line, "Categories") && ! categories)
+            categories = __m_wastrdup(value);
+        else if (! strcmp(line, "Type"))
+            app = ! strcmp(value, "Application");
+        else if (! strcmp(line, "NoDisplay") || ! strcmp(line, "Hidden"))
+            hidden = hidden || ! strcmp(value, "true");
+    }
+    fclose(fd);
+
+    *category = app_category(categories);
+    if (categories) delete [] categories;
+    if (! app || hidden || ! *name || ! *exec || ! **exec) {
+        if (*name) delete [] *name;
+        if (*exec) delete [] *exec;
+        if (*icon) delete [] *icon;
+        return false;
+    }
+    for (s = d = *exec; *s != '\0'; s++) {
+        if (*s == '%' && s[1] != '\0') {
+            if (*++s == '%') *d++ = '%';
+            else if (! strchr("fFuUdDnNickvm", *s)) {
+                *d++ = '%';
+                *d++ = *s;
+            }
+        } else
+            *d++ = *s;
+    }
+    for (; d > *exec && d[-1] == ' '; d--);
+    *d = '\0';
+    return true;
+}
+
+/**
+ * @fn    ApplicationMenu(const char *n, WaScreen *ws, const char *c) :
+ *        GeneratedMenu(n, ws, c)
+ * @brief Constructor for ApplicationMenu class
+ *
+ * Creates an ApplicationMenu object, a menu listing applications installed
+ * as desktop entry files in XDG data directories.
+ *
+ * @param n Menu name
+ * @param ws WaScreen menu belongs to
+ * @param c Main category to list applications for, NULL for a menu with
+ *          one submenu for each main category
+ */
+ApplicationMenu::ApplicationMenu(const char *n, WaScreen *ws,
+                                 const char *c) :
+    GeneratedMenu(n, ws, (c)? app_category_label(c): "Applications") {
+    char *__m_wastrdup_tmp;
+
+    category = (c)? __m_wastrdup(c): NULL;
+}
+
+/**
+ * @fn    ~ApplicationMenu(void)
+ * @brief Destructor for ApplicationMenu class
+ */
+ApplicationMenu::~ApplicationMenu(void) {
+    if (category) delete [] category;
+}
+
+/**
+ * @fn    Generate(void)
+ * @brief Generates ApplicationMenu items
+ *
+ * Reads desktop entry files from applications directory of XDG_DATA_HOME
+ * and XDG_DATA_DIRS. Desktop entries in earlier directories override
+ * entries with the same file name in later directories.
+ */
+void ApplicationMenu::Generate(void) {
+    list<WaMenuItem *> items;
+    list<char *> ids;
+    list<char *>::iterator iit;
+    bool used[sizeof(app_categories) / sizeof(app_categories[0])];
+    const char *home = getenv("HOME"), *data_home = getenv("XDG_DATA_HOME");
+    const char *data_dirs = getenv("XDG_DATA_DIRS");
+    char *dirs, *dir, *next, *file, *name, *exec, *icon;
+    struct dirent *ent;
+    WaMenuItem *m;
+    DIR *dp;
+    int i, len, cat;
+
+    m = new WaMenuItem(title);
+    m->type = MenuTitleType;
+    AddItem(m);
+
+    memset(used, 0, sizeof(used));
+    if (! data_dirs || *data_dirs == '\0')
+        data_dirs = "/usr/local/share:/usr/share";
+    if (! home) home = "";
+    dirs = new char[strlen(data_dirs) + strlen(home) + 16 +
+                    ((data_home)? strlen(data_home): 0)];
+    if (data_home && *data_home)
+        sprintf(dirs, "%s:%s", data_home, data_dirs);
+    else
+        sprintf(dirs, "%s/.local/share:%s", home, data_dirs);
+
+    for (dir = dirs; dir; dir = next) {
+        if ((next = strchr(dir, ':'))) *next++ = '\0';
+        if (*dir == '\0') continue;
+        len = strlen(dir) + 14;
+        char *appdir = new char[len];
+        sprintf(appdir, "%s/applications", dir);
+        if (! (dp = opendir(appdir))) {
+            delete [] appdir;
+            continue;
+        }
+        Watch(appdir);
+        while ((ent = readdir(dp))) {
+            i = strlen(ent->d_name);
+            if (i < 9 || strcmp(ent->d_name + i - 8, ".desktop")) continue;
+            for (iit = ids.begin(); iit != ids.end() &&
+                     strcmp(*iit, ent->d_name); ++iit);
+            if (iit != ids.end()) continue;
+            ids.push_back(strcpy(new char[i + 1], ent->d_name));
+
+            file = new char[len + i + 1];
+            sprintf(file, "%s/%s", appdir, ent->d_name);
+            if (read_desktop_entry(file, &name, &exec, &icon, &cat)) {
+                if (! category)
+                    used[cat] = true;
+                else if (! strcmp(app_categories[cat].name, category)) {
+                    m = new WaMenuItem(name);
+                    m->type = MenuItemType;
+                    m->exec = m->exec1 = exec;
+                    m->func_mask |= MenuExecMask;
+                    m->func_mask1 |= MenuExecMask;
+                    if (icon && *icon == '/') {
+                        m->icon_file = icon;
+                        icon = NULL;
+                    }
+                    items.push_back(m);
+                    exec = NULL;
+                }
+                delete [] name;
+                if (exec) delete [] exec;
+                if (icon) delete [] icon;
+            }
+            delete [] file;
+        }
+        closedir(dp);
+        delete [] appdir;
+    }
+    delete [] dirs;
+    for (iit = ids.begin(); iit != ids.end(); ++iit) delete [] *iit;
+
+    for (i = 0; app_categories[i].name; i++) {
+        if (! used[i]) continue;
+        m = new WaMenuItem(app_categories[i].label);
+        m->type = MenuSubType;
+        m->sub = m->sub1 = new char[strlen(app_categories[i].name) + 32];
+        sprintf(m->sub, "applications!@applications %s",
+                app_categories[i].name);
+        m->func_mask |= MenuSubMask;
+        m->func_mask1 |= MenuSubMask;
+        AddItem(m);
+    }
+    items.sort(item_label_cmp);
+    list<WaMenuItem *>::iterator it = items.begin();
+    for (; it != items.end(); ++it) AddItem(*it);
+}
 
 /**
  * Wrapper functions.
@@ -2130,6 +2722,15 @@ void WaMenuItem::NextDesktop(XEvent *, WaAction *) {
 void WaMenuItem::PreviousDesktop(XEvent *, WaAction *) {
     menu->wascreen->PreviousDesktop(NULL, NULL);
 }
+void WaMenuItem::JoinDesktopMatch(XEvent *e, WaAction *ac) {
+    menu->wascreen->JoinDesktopMatch(e, ac);
+}
+void WaMenuItem::PartDesktopMatch(XEvent *e, WaAction *ac) {
+    menu->wascreen->PartDesktopMatch(e, ac);
+}
+void WaMenuItem::DesktopMaskMatch(XEvent *e, WaAction *ac) {
+    menu->wascreen->DesktopMaskMatch(e, ac);
+}
 void WaMenuItem::Restart(XEvent *e, WaAction *ac) {
     menu->wascreen->Restart(e, ac);
 }
@@ -55,10 +55,17 @@ public:
     void CreateOutline(void);
     void DestroyOutline(void);
     void DrawOutline(int, int);
+    void AddOutline(int, int);
     void Raise(void);
     void Lower(void);
     void FocusFirst(void);
 
+#ifdef PIXMAP
+    void LoadIcons(void);
+#endif // PIXMAP
+
+    inline virtual void Update(void) {}
+
     Waimea *waimea;
     Display *display;
     WaScreen *wascreen;
@@ -66,10 +73,10 @@ public:
 
     list<WaMenuItem *> item_list;
 
-    Window frame, o_west, o_north, o_south, o_east;
+    Window frame;
     int x, y, width, height, bullet_width, cb_width, extra_width;
     bool mapped, built, has_focus, dynamic, dynamic_root, ignore, db,
-        cb_db_upd;
+        cb_db_upd, icons;
     char *name;
     Pixmap pbackframe, ptitle, philite, psub, psubhilite;
     unsigned long backframe_pixel, title_pixel, hilite_pixel,
@@ -180,6 +187,9 @@ public:
     void GoToDesktop(XEvent *, WaAction *);
     void PreviousDesktop(XEvent *, WaAction *);
     void NextDesktop(XEvent *, WaAction *);
+    void JoinDesktopMatch(XEvent *, WaAction *);
+    void PartDesktopMatch(XEvent *, WaAction *);
+    void DesktopMaskMatch(XEvent *, WaAction *);
     void Restart(XEvent *, WaAction *);
     void Exit(XEvent *, WaAction *);
     inline void Nop(XEvent *, WaAction *) {}
@@ -195,6 +205,9 @@ public:
     char *label1, *exec1, *param1, *sub1;
     char *label2, *exec2, *param2, *sub2;
     char *e_label, *e_label1, *e_label2, *e_sub, *e_sub1, *e_sub2;
+    char *icon_file;
+    WaIcon *icon;
+    WaText text;
     char *cbox;
     WwActionFn wfunc, wfunc1, wfunc2;
     MenuActionFn mfunc, mfunc1, mfunc2;
@@ -237,4 +250,46 @@ private:
     char *mergelabel;
 };
 
+class GeneratedMenu : public WaMenu {
+public:
+    GeneratedMenu(const char *, WaScreen *, const char *);
+    virtual ~GeneratedMenu(void);
+
+    void Update(void);
+    void Invalidate(int, bool = false);
+    virtual void Generate(void) = 0;
+
+    bool stale;
+
+protected:
+    void Watch(const char *);
+
+    char *title;
+
+private:
+    list<int> watches;
+};
+
+class DirectoryMenu : public GeneratedMenu {
+public:
+    DirectoryMenu(const char *, WaScreen *, const char *, const char *);
+    virtual ~DirectoryMenu(void);
+
+    void Generate(void);
+
+private:
+    char *path, *command;
+};
+
+class ApplicationMenu : public GeneratedMenu {
+public:
+    ApplicationMenu(const char *, WaScreen *, const char *);
+    virtual ~ApplicationMenu(void);
+
+    void Generate(void);
+
+private:
+    char *category;
+};
+
 #endif // __Menu_hh
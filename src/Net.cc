@@ -24,6 +24,9 @@ extern "C" {
 }
 
 #include "Net.hh"
+#include "Icon.hh"
+
+extern bool hush;
 
 /**
  * @fn    NetHandler(Waimea *wa)
@@ -46,6 +49,9 @@ NetHandler::NetHandler(Waimea *wa) {
 
     wm_state = XInternAtom(display, "WM_STATE", false);
     wm_change_state = XInternAtom(display, "WM_CHANGE_STATE", false);
+    wm_protocols = XInternAtom(display, "WM_PROTOCOLS", false);
+    wm_take_focus = XInternAtom(display, "WM_TAKE_FOCUS", false);
+    wm_client_leader = XInternAtom(display, "WM_CLIENT_LEADER", false);
 
     net_supported = XInternAtom(display, "_NET_SUPPORTED", false);
     net_supported_wm_check =
@@ -68,6 +74,9 @@ NetHandler::NetHandler(Waimea *wa) {
 
     net_wm_desktop = XInternAtom(display, "_NET_WM_DESKTOP", false);
     net_wm_name = XInternAtom(display, "_NET_WM_NAME", false);
+    net_wm_icon = XInternAtom(display, "_NET_WM_ICON", false);
+    net_wm_strut_partial = XInternAtom(display, "_NET_WM_STRUT_PARTIAL",
+                                       false);
     net_wm_visible_name = XInternAtom(display, "_NET_WM_VISIBLE_NAME", false);
     net_wm_strut = XInternAtom(display, "_NET_WM_STRUT", false);
     net_wm_pid = XInternAtom(display, "_NET_WM_PID", false);
@@ -133,6 +142,9 @@ NetHandler::NetHandler(Waimea *wa) {
     net_moveresize_window =
         XInternAtom(display, "_NET_MOVERESIZE_WINDOW", false);
     net_wm_moveresize = XInternAtom(display, "_NET_WM_MOVERESIZE", false);
+    net_frame_extents = XInternAtom(display, "_NET_FRAME_EXTENTS", false);
+    net_request_frame_extents =
+        XInternAtom(display, "_NET_REQUEST_FRAME_EXTENTS", false);
 
     waimea_net_wm_state_decor =
         XInternAtom(display, "_WAIMEA_NET_WM_STATE_DECOR", false);
@@ -171,10 +183,8 @@ NetHandler::NetHandler(Waimea *wa) {
     kde_net_wm_system_tray_window_for =
         XInternAtom(display, "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR", false);
 
-#ifdef RENDER
     xrootpmap_id =
         XInternAtom(display, "_XROOTPMAP_ID", false);
-#endif // RENDER
 
     event.type = ClientMessage;
     event.xclient.display = display;
@@ -199,22 +209,48 @@ NetHandler::~NetHandler(void) {
  * @fn    GetWMHints(WaWindow *ww)
  * @brief Read WM hints
  *
- * Reads WaWindows WM hints.
+ * Reads WaWindows WM hints. The input model of the window is classified
+ * from the input hint and WM_TAKE_FOCUS protocol. The application group
+ * leader is taken from the window_group hint or, if not set, from the
+ * WM_CLIENT_LEADER property.
  *
  * @param ww WaWindow object
  */
 void NetHandler::GetWMHints(WaWindow *ww) {
     XTextProperty text_prop;
     char **list;
+    Atom *protocols;
+    Window *leader;
     int num;
     char *__m_wastrdup_tmp;
 
     ww->state = NormalState;
+    ww->input_hint = true;
+    ww->take_focus = false;
+    ww->group = None;
     XGrabServer(display);
     if (validatedrawable(ww->id)) {
         if ((wm_hints = XGetWMHints(display, ww->id))) {
             if (wm_hints->flags & StateHint)
                 ww->state = wm_hints->initial_state;
+            if (wm_hints->flags & InputHint)
+                ww->input_hint = wm_hints->input;
+            if (wm_hints->flags & WindowGroupHint)
+                ww->group = wm_hints->window_group;
+        }
+        if (ww->group == None &&
+            XGetWindowProperty(display, ww->id, wm_client_leader, 0L, 1L,
+                               false, XA_WINDOW, &real_type, &real_format,
+                               &items_read, &items_left,
+                               (unsigned char **) &leader) ==
+            Success && items_read) {
+            ww->group = *leader;
+            XFree(leader);
+        }
+        if (XGetWMProtocols(display, ww->id, &protocols, &num)) {
+            for (int i = 0; i < num; i++)
+                if (protocols[i] == wm_take_focus) ww->take_focus = true;
+            XFree(protocols);
         }
         ww->classhint = XAllocClassHint();
         XGetClassHint(ww->display, ww->id, ww->classhint);
@@ -310,6 +346,9 @@ void NetHandler::GetWMNormalHints(WaWindow *ww) {
         ww->size.height_inc = 1;
     ww->size.base_width = ww->size.min_width;
     ww->size.base_height = ww->size.min_height;
+    ww->size.min_aspect_x = ww->size.min_aspect_y = ww->size.max_aspect_x =
+        ww->size.max_aspect_y = 0;
+    ww->size.base_size = false;
 
     size_hints->flags = 0;
     XGrabServer(display);
@@ -334,6 +373,21 @@ void NetHandler::GetWMNormalHints(WaWindow *ww) {
         if (size_hints->flags & PBaseSize) {
             ww->size.base_width = size_hints->base_width;
             ww->size.base_height = size_hints->base_height;
+            ww->size.base_size = true;
+        }
+        else if (size_hints->flags & PMinSize) {
+            ww->size.base_width = size_hints->min_width;
+            ww->size.base_height = size_hints->min_height;
+        }
+        if (size_hints->flags & PAspect) {
+            if (size_hints->min_aspect.x > 0 && size_hints->min_aspect.y > 0) {
+                ww->size.min_aspect_x = size_hints->min_aspect.x;
+                ww->size.min_aspect_y = size_hints->min_aspect.y;
+            }
+            if (size_hints->max_aspect.x > 0 && size_hints->max_aspect.y > 0) {
+                ww->size.max_aspect_x = size_hints->max_aspect.x;
+                ww->size.max_aspect_y = size_hints->max_aspect.y;
+            }
         }
         if (size_hints->flags & PWinGravity)
             ww->size.win_gravity = size_hints->win_gravity;
@@ -405,13 +459,7 @@ void NetHandler::SetState(WaWindow *ww, int newstate) {
                      (1L << ww->wascreen->current_desktop->number))
                 ww->Show();
     }
-    if (ww->want_focus && ww->mapped && !ww->hidden) {
-        XGrabServer(display);
-        if (validatedrawable(ww->id))
-            XSetInputFocus(display, ww->id, RevertToPointerRoot, CurrentTime);
-        else WW_DELETED;
-        XUngrabServer(display);
-    }
+    if (ww->want_focus && ww->mapped && !ww->hidden) ww->FocusClient();
 
     ww->want_focus = false;
 
@@ -570,7 +618,7 @@ void NetHandler::SetWmState(WaWindow *ww) {
  * @param ws WaScreen object
  */
 void NetHandler::SetSupported(WaScreen *ws) {
-    long data[52];
+    long data[64];
     int i = 0;
 
     data[i++] = net_supported;
@@ -591,6 +639,7 @@ void NetHandler::SetSupported(WaScreen *ws) {
     data[i++] = net_wm_name;
     data[i++] = net_wm_visible_name;
     data[i++] = net_wm_strut;
+    data[i++] = net_wm_strut_partial;
     data[i++] = net_wm_pid;
 
     data[i++] = net_wm_state;
@@ -631,6 +680,8 @@ void NetHandler::SetSupported(WaScreen *ws) {
     data[i++] = net_close_window;
     data[i++] = net_moveresize_window;
     data[i++] = net_wm_moveresize;
+    data[i++] = net_frame_extents;
+    data[i++] = net_request_frame_extents;
 
     XChangeProperty(display, ws->id, net_supported, XA_ATOM, 32,
                     PropModeReplace, (unsigned char *) data, i);
@@ -853,27 +904,35 @@ void NetHandler::GetVirtualPos(WaWindow *ww) {
  * @brief Reads window title
  *
  * Reads WM_NAME hint and if hint exists the window title is set to this
- * and _NET_WM_VISIBLE_HINT is updated.
+ * and _NET_WM_VISIBLE_HINT is updated. The title is converted to UTF-8.
  *
  * @param ww WaWindow object
  */
 void NetHandler::GetXaName(WaWindow *ww) {
-    char *data = NULL;
-    int status = 0;
+    XTextProperty text_prop;
+    char **list = NULL;
+    int status = 0, n;
     char *__m_wastrdup_tmp;
 
     XGrabServer(display);
     if (validatedrawable(ww->id)) {
-        status = XFetchName(display, ww->id, &data);
+        status = XGetWMName(display, ww->id, &text_prop);
     } else ww->deleted = true;
     XUngrabServer(display);
 
-    if (status && data) {
+    if (status) {
+        if (text_prop.value && text_prop.nitems &&
+            Xutf8TextPropertyToTextList(display, &text_prop, &list,
+                                        &n) < Success)
+            list = NULL;
+        XFree(text_prop.value);
+    }
+
+    if (list) {
         ww->wascreen->SmartNameRemove(ww);
-        delete [] ww->name;
-        ww->name = __m_wastrdup(data);
+        ww->SetName(__m_wastrdup((n > 0)? *list: ""));
         ww->realnamelen = strlen(ww->name);
-        XFree(data);
+        XFreeStringList(list);
         ww->SetActionLists();
 
         ww->wascreen->SmartName(ww);
@@ -909,8 +968,7 @@ bool NetHandler::GetNetName(WaWindow *ww) {
 
     if (status == Success && items_read) {
         ww->wascreen->SmartNameRemove(ww);
-        delete [] ww->name;
-        ww->name = __m_wastrdup(data);
+        ww->SetName(__m_wastrdup(data));
         ww->realnamelen = strlen(ww->name);
         ww->SetActionLists();
         XFree(data);
@@ -991,51 +1049,75 @@ void NetHandler::SetVirtualPos(WaWindow *ww) {
  * @fn    GetWmStrut(WaWindow *ww)
  * @brief Reads strut hint
  *
- * Reads windows _NET_WM_STRUT hint, adds it to the strut list and updates
- * workarea.
+ * Reads windows _NET_WM_STRUT_PARTIAL hint, or _NET_WM_STRUT hint if
+ * partial strut isn't set. Workarea is only updated if strut changed.
  *
  * @param ww WaWindow object
  */
 void NetHandler::GetWmStrut(WaWindow *ww) {
-    long *data;
-    WMstrut *wm_strut;
-    bool found = false;
+    long *data = NULL;
+    WMstrut strut;
     int status;
 
-    XGrabServer(display);
-    if (validatedrawable(ww->id)) {
+    memset(&strut, 0, sizeof(WMstrut));
+    status = XGetWindowProperty(display, ww->id, net_wm_strut_partial, 0L,
+                                12L, false, XA_CARDINAL, &real_type,
+                                &real_format, &items_read, &items_left,
+                                (unsigned char **) &data);
+    if (status != Success || items_read < 12) {
+        if (status == Success && data) XFree(data);
+        data = NULL;
         status = XGetWindowProperty(display, ww->id, net_wm_strut, 0L, 4L,
                                     false, XA_CARDINAL, &real_type,
                                     &real_format, &items_read, &items_left,
                                     (unsigned char **) &data);
-    } else WW_DELETED;
-    XUngrabServer(display);
-
-    if (status == Success && items_read >= 4) {
-        list<WMstrut *>::iterator it = ww->wascreen->strut_list.begin();
-        for (; it != ww->wascreen->strut_list.end(); ++it) {
-            if ((*it)->window == ww->id) {
-                (*it)->left = data[0];
-                (*it)->right = data[1];
-                (*it)->top = data[2];
-                (*it)->bottom = data[3];
-                found = true;
-                ww->wascreen->UpdateWorkarea();
-            }
+        if (status != Success || items_read < 4) {
+            if (status == Success && data) XFree(data);
+            data = NULL;
         }
-        if (! found) {
-            wm_strut = new WMstrut;
-            wm_strut->window = ww->id;
-            wm_strut->left = data[0];
-            wm_strut->right = data[1];
-            wm_strut->top = data[2];
-            wm_strut->bottom = data[3];
-            ww->wm_strut = wm_strut;
-            ww->wascreen->strut_list.push_back(wm_strut);
+    }
+
+    if (! data) {
+        if (ww->wm_strut) {
+            ww->wascreen->strut_list.remove(ww->wm_strut);
+            delete ww->wm_strut;
+            ww->wm_strut = NULL;
             ww->wascreen->UpdateWorkarea();
         }
-        XFree(data);
+        return;
+    }
+
+    strut.window = ww->id;
+    strut.left = data[0];
+    strut.right = data[1];
+    strut.top = data[2];
+    strut.bottom = data[3];
+    if (items_read >= 12) {
+        strut.left_start = data[4];
+        strut.left_end = data[5];
+        strut.right_start = data[6];
+        strut.right_end = data[7];
+        strut.top_start = data[8];
+        strut.top_end = data[9];
+        strut.bottom_start = data[10];
+        strut.bottom_end = data[11];
+    } else {
+        strut.left_start = strut.right_start = 0;
+        strut.left_end = strut.right_end = ww->wascreen->height - 1;
+        strut.top_start = strut.bottom_start = 0;
+        strut.top_end = strut.bottom_end = ww->wascreen->width - 1;
+    }
+    XFree(data);
+
+    if (ww->wm_strut) {
+        if (! memcmp(ww->wm_strut, &strut, sizeof(WMstrut))) return;
+        *ww->wm_strut = strut;
+    } else {
+        ww->wm_strut = new WMstrut;
+        *ww->wm_strut = strut;
+        ww->wascreen->strut_list.push_back(ww->wm_strut);
     }
+    ww->wascreen->UpdateWorkarea();
 }
 
 /**
@@ -1066,6 +1148,39 @@ void NetHandler::GetWmPid(WaWindow *ww) {
     XUngrabServer(display);
 }
 
+/**
+ * @fn    GetWmIcon(WaWindow *ww)
+ * @brief Reads _NET_WM_ICON hint
+ *
+ * Reads windows _NET_WM_ICON hint and replaces WaWindows icon with an
+ * icon scaled to fit menu items.
+ *
+ * @param ww WaWindow object
+ */
+void NetHandler::GetWmIcon(WaWindow *ww) {
+    unsigned long *data = NULL;
+    WaIcon *icon = NULL;
+    int status = 0;
+
+    XGrabServer(display);
+    if (validatedrawable(ww->id)) {
+        status = XGetWindowProperty(ww->display, ww->id, net_wm_icon, 0L,
+                                    (1L << 20), false, XA_CARDINAL,
+                                    &real_type, &real_format, &items_read,
+                                    &items_left, (unsigned char **) &data);
+    } else ww->deleted = true;
+    XUngrabServer(display);
+
+    if (status == Success) {
+        if (real_type == XA_CARDINAL && real_format == 32 && items_read)
+            icon = WaIcon::Get(ww->wascreen, data, items_read,
+                               ww->wascreen->mstyle.item_height - 2);
+        if (data) XFree(data);
+    }
+    if (ww->icon) ww->icon->Release();
+    ww->icon = icon;
+}
+
 /**
  * @fn    GetDesktopViewPort(WaScreen *ws)
  * @brief Reads viewport hint
@@ -1301,6 +1416,29 @@ void NetHandler::GetXRootPMapId(WaScreen *ws) {
 }
 #endif // RENDER
 
+#ifdef PIXMAP
+/**
+ * @fn    SetXRootPMapId(WaScreen *ws, Pixmap pixmap)
+ * @brief Writes XROOTPMAPID hint
+ *
+ * Sets _XROOTPMAP_ID hint to the pixmap used as root window background.
+ *
+ * @param ws WaScreen object
+ * @param pixmap Root window background pixmap, None deletes hint
+ */
+void NetHandler::SetXRootPMapId(WaScreen *ws, Pixmap pixmap) {
+    long data[1];
+
+    if (pixmap == None) {
+        XDeleteProperty(ws->display, ws->id, xrootpmap_id);
+        return;
+    }
+    data[0] = pixmap;
+    XChangeProperty(ws->display, ws->id, xrootpmap_id, XA_PIXMAP, 32,
+                    PropModeReplace, (unsigned char *) data, 1);
+}
+#endif // PIXMAP
+
 /**
  * @fn    GetType(WaWindow *ww)
  * @brief Read type hint
@@ -1441,6 +1579,107 @@ void NetHandler::SetDesktopMask(WaWindow *ww) {
     XUngrabServer(display);
 }
 
+/**
+ * @fn    SetDesktops(list<WaWindow *> *wins)
+ * @brief Write desktop hints for a list of windows
+ *
+ * Writes _NET_WM_DESKTOP and _WAIMEA_NET_WM_DESKTOP_MASK hints for all
+ * windows in list within one server grab. Windows aren't validated one at
+ * a time, errors from windows that have been destroyed are ignored.
+ *
+ * @param wins List of windows
+ */
+void NetHandler::SetDesktops(list<WaWindow *> *wins) {
+    long data[1];
+    int i;
+
+    XGrabServer(display);
+    XSync(display, false);
+    hush = 1;
+    list<WaWindow *>::iterator it = wins->begin();
+    for (; it != wins->end(); ++it) {
+        WaWindow *ww = *it;
+        data[0] = 0;
+        if (ww->desktop_mask & (1L << ww->wascreen->current_desktop->number))
+            data[0] = ww->wascreen->current_desktop->number;
+        else {
+            for (i = 0; i < 16; i++)
+                if (ww->desktop_mask & (1L << i)) {
+                    data[0] = i;
+                    break;
+                }
+        }
+        if (ww->desktop_mask == ((1L << 16) - 1))
+            data[0] = 0xffffffff;
+        XChangeProperty(display, ww->id, net_wm_desktop, XA_CARDINAL, 32,
+                        PropModeReplace, (unsigned char *) data, 1);
+
+        data[0] = ww->desktop_mask;
+        XChangeProperty(display, ww->id, waimea_net_wm_desktop_mask,
+                        XA_CARDINAL, 32, PropModeReplace,
+                        (unsigned char *) data, 1);
+    }
+    XSync(display, false);
+    hush = 0;
+    XUngrabServer(display);
+}
+
+/**
+ * @fn    SetFrameExtents(WaWindow *ww)
+ * @brief Writes frame extents hint
+ *
+ * Sets _NET_FRAME_EXTENTS hint to the size of the window decorations. The
+ * hint is only written if the extents have changed since last time.
+ *
+ * @param ww WaWindow object
+ */
+void NetHandler::SetFrameExtents(WaWindow *ww) {
+    long data[4];
+    int i;
+
+    data[0] = data[1] = data[2] = data[3] = ww->border_w;
+    if (ww->title_w) data[2] += ww->title_w + ww->border_w;
+    if (ww->handle_w) data[3] += ww->handle_w + ww->border_w;
+
+    for (i = 0; i < 4 && data[i] == ww->frame_extents[i]; i++);
+    if (i == 4) return;
+
+    XGrabServer(display);
+    if (validatedrawable(ww->id)) {
+        XChangeProperty(display, ww->id, net_frame_extents, XA_CARDINAL, 32,
+                        PropModeReplace, (unsigned char *) data, 4);
+        for (i = 0; i < 4; i++) ww->frame_extents[i] = data[i];
+    } else ww->deleted = true;
+    XUngrabServer(display);
+}
+
+/**
+ * @fn    SetRequestedFrameExtents(Window win)
+ * @brief Answers frame extents request
+ *
+ * Sets _NET_FRAME_EXTENTS hint on a window that isn't managed yet. The
+ * extents are calculated from the window style of the screen, assuming
+ * that the window will get all decorations.
+ *
+ * @param win Window requesting frame extents
+ */
+void NetHandler::SetRequestedFrameExtents(Window win) {
+    XWindowAttributes attrib;
+    WaScreen *ws;
+    long data[4];
+
+    XGrabServer(display);
+    if (validatedrawable(win) && XGetWindowAttributes(display, win, &attrib) &&
+        (ws = (WaScreen *) waimea->FindWin(attrib.root, RootType))) {
+        data[0] = data[1] = ws->wstyle.border_width;
+        data[2] = ws->wstyle.title_height + ws->wstyle.border_width * 2;
+        data[3] = ws->wstyle.handle_width + ws->wstyle.border_width * 2;
+        XChangeProperty(display, win, net_frame_extents, XA_CARDINAL, 32,
+                        PropModeReplace, (unsigned char *) data, 4);
+    }
+    XUngrabServer(display);
+}
+
 /**
  * @fn    GetDesktop(WaWindow *ww)
  * @brief Reads net_wm_desktop and net_desktop_mask hints
@@ -1479,6 +1718,27 @@ void NetHandler::GetDesktop(WaWindow *ww) {
     XUngrabServer(display);
 }
 
+/**
+ * @fn    IsWmProperty(Atom atom)
+ * @brief Checks if property is maintained by window manager
+ *
+ * @param atom Property atom to check
+ *
+ * @return True if atom is a client window property set by waimea
+ */
+bool NetHandler::IsWmProperty(Atom atom) {
+    return (atom == wm_state || atom == net_wm_state ||
+            atom == net_wm_desktop || atom == net_wm_visible_name ||
+            atom == net_wm_allowed_actions || atom == net_frame_extents ||
+            atom == waimea_net_maximized_restore ||
+            atom == waimea_net_virtual_pos ||
+            atom == waimea_net_wm_desktop_mask ||
+            atom == waimea_net_wm_merged_to ||
+            atom == waimea_net_wm_merged_type ||
+            atom == waimea_net_wm_merge_order ||
+            atom == waimea_net_wm_merge_atfront);
+}
+
 /**
  * @fn    IsSystrayWindow(Window w)
  * @brief Checks if window is systray window
@@ -73,13 +73,17 @@ public:
     void SetVirtualPos(WaWindow *);
     void GetWmStrut(WaWindow *);
     void GetWmPid(WaWindow *);
+    void GetWmIcon(WaWindow *);
     void GetXaName(WaWindow *);
     bool GetNetName(WaWindow *);
     void SetVisibleName(WaWindow *);
     void RemoveVisibleName(WaWindow *);
     void SetDesktop(WaWindow *);
     void SetDesktopMask(WaWindow *);
+    void SetDesktops(list<WaWindow *> *);
     void GetDesktop(WaWindow *);
+    void SetFrameExtents(WaWindow *);
+    void SetRequestedFrameExtents(Window);
 
     void SetSupported(WaScreen *);
     void SetSupportedWMCheck(WaScreen *, Window);
@@ -106,6 +110,10 @@ public:
     void GetXRootPMapId(WaScreen *);
 #endif // RENDER
 
+#ifdef PIXMAP
+    void SetXRootPMapId(WaScreen *, Pixmap);
+#endif // PIXMAP
+
     void GetWmType(WaWindow *);
 
     void SetAllowedActions(WaWindow *);
@@ -119,6 +127,7 @@ public:
     void SetMergeOrder(WaWindow *);
 
     bool IsSystrayWindow(Window);
+    bool IsWmProperty(Atom);
     void SetSystrayWindows(WaScreen *);
 
     Waimea *waimea;
@@ -130,14 +139,15 @@ public:
     Atom utf8_string;
 
     Atom mwm_hints_atom;
-    Atom wm_state, wm_change_state;
+    Atom wm_state, wm_change_state, wm_protocols, wm_take_focus;
+    Atom wm_client_leader;
 
     Atom net_supported, net_supported_wm_check;
     Atom net_client_list, net_client_list_stacking, net_active_window;
     Atom net_desktop_viewport, net_desktop_geometry, net_current_desktop,
         net_number_of_desktops, net_desktop_names, net_workarea;
-    Atom net_wm_desktop, net_wm_name, net_wm_visible_name, net_wm_strut,
-        net_wm_pid;
+    Atom net_wm_desktop, net_wm_name, net_wm_icon, net_wm_visible_name,
+        net_wm_strut, net_wm_strut_partial, net_wm_pid;
     Atom net_wm_state, net_wm_state_sticky, net_wm_state_shaded,
         net_wm_state_hidden, net_wm_maximized_vert, net_wm_maximized_horz,
         net_wm_state_above, net_wm_state_below, net_wm_state_stays_on_top,
@@ -154,6 +164,7 @@ public:
         net_wm_window_type_dialog, net_wm_window_type_utility,
         net_wm_window_type_normal;
     Atom net_close_window, net_moveresize_window, net_wm_moveresize;
+    Atom net_frame_extents, net_request_frame_extents;
 
     Atom waimea_net_wm_state_decor, waimea_net_wm_state_decortitle,
         waimea_net_wm_state_decorhandle,
@@ -168,9 +179,7 @@ public:
 
     Atom kde_net_wm_system_tray_window_for, kde_net_system_tray_windows;
 
-#ifdef RENDER
     Atom xrootpmap_id;
-#endif // RENDER
 
 private:
     XEvent event;
@@ -0,0 +1,235 @@
+/**
+ * @file   Outline.cc
+ * @author David Reveman <david@waimea.org>
+ * @date   18-Oct-2026 20:57:26
+ *
+ * @brief Implementation of WaOutline class
+ *
+ * Outline used for non opaque moving and resizing. One outline window is
+ * created for each screen and kept for the lifetime of the screen.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#ifdef    SHAPE
+#  include <X11/extensions/shape.h>
+#endif // SHAPE
+
+#ifdef    HAVE_STRING_H
+#  include <string.h>
+#endif // HAVE_STRING_H
+}
+
+#include "Outline.hh"
+
+/**
+ * @fn    WaOutline(WaScreen *scrn)
+ * @brief Constructor for WaOutline class
+ *
+ * Creates a screen sized outline window with an empty bounding shape if
+ * shape extension is available. The outline window is put on top of the
+ * always on top stacking layer.
+ *
+ * @param scrn WaScreen to create outline for
+ */
+WaOutline::WaOutline(WaScreen *scrn) {
+    wascreen = scrn;
+    display = wascreen->display;
+    mapped = use_shape = false;
+    id = None;
+    n_rects = parts_mapped = 0;
+    max_rects = 16;
+    rects = new XRectangle[max_rects];
+
+#ifdef SHAPE
+    if (wascreen->waimea->shape) {
+        use_shape = true;
+        id = CreatePart();
+        XResizeWindow(display, id, wascreen->width, wascreen->height);
+        XShapeCombineRectangles(display, id, ShapeBounding, 0, 0, NULL, 0,
+                                ShapeSet, YXBanded);
+    }
+#endif // SHAPE
+
+}
+
+/**
+ * @fn    ~WaOutline(void)
+ * @brief Destructor for WaOutline class
+ *
+ * Destroys outline windows.
+ */
+WaOutline::~WaOutline(void) {
+    if (id != None) {
+        wascreen->aot_stacking_list.remove(id);
+        XDestroyWindow(display, id);
+    }
+    while (! parts.empty()) {
+        wascreen->aot_stacking_list.remove(parts.front());
+        XDestroyWindow(display, parts.front());
+        parts.pop_front();
+    }
+    delete [] rects;
+}
+
+/**
+ * @fn    CreatePart(void)
+ * @brief Creates outline window
+ *
+ * @return Override redirect window with outline color as background
+ */
+Window WaOutline::CreatePart(void) {
+    XSetWindowAttributes attrib_set;
+
+    int create_mask = CWOverrideRedirect | CWBackPixel | CWEventMask |
+        CWColormap | CWBorderPixel;
+    attrib_set.background_pixel = wascreen->wstyle.outline_color.getPixel();
+    attrib_set.border_pixel = attrib_set.background_pixel;
+    attrib_set.colormap = wascreen->colormap;
+    attrib_set.override_redirect = true;
+    attrib_set.event_mask = NoEventMask;
+
+    Window w = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
+                             wascreen->screen_depth, CopyFromParent,
+                             wascreen->visual, create_mask, &attrib_set);
+    wascreen->aot_stacking_list.push_front(w);
+
+    return w;
+}
+
+/**
+ * @fn    Map(void)
+ * @brief Starts outline drawing
+ *
+ * Outline windows aren't mapped until first Draw call.
+ */
+void WaOutline::Map(void) {
+    mapped = true;
+    n_rects = 0;
+}
+
+/**
+ * @fn    Unmap(void)
+ * @brief Ends outline drawing
+ *
+ * Unmaps outline windows.
+ */
+void WaOutline::Unmap(void) {
+    if (! mapped) return;
+    mapped = false;
+    if (use_shape) {
+        if (parts_mapped) XUnmapWindow(display, id);
+        parts_mapped = 0;
+    } else {
+        list<Window>::iterator it = parts.begin();
+        for (; parts_mapped > 0; ++it, parts_mapped--)
+            XUnmapWindow(display, *it);
+    }
+}
+
+/**
+ * @fn    Clear(void)
+ * @brief Removes all rectangles from outline
+ */
+void WaOutline::Clear(void) {
+    n_rects = 0;
+}
+
+/**
+ * @fn    AddRect(int x, int y, int width, int height)
+ * @brief Adds rectangle to outline
+ *
+ * @param x X position of rectangle
+ * @param y Y position of rectangle
+ * @param width Width of rectangle
+ * @param height Height of rectangle
+ */
+void WaOutline::AddRect(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    if (n_rects == max_rects) {
+        XRectangle *tmp = new XRectangle[max_rects * 2];
+        memcpy(tmp, rects, max_rects * sizeof(XRectangle));
+        delete [] rects;
+        rects = tmp;
+        max_rects *= 2;
+    }
+    rects[n_rects].x = x;
+    rects[n_rects].y = y;
+    rects[n_rects].width = width;
+    rects[n_rects].height = height;
+    n_rects++;
+}
+
+/**
+ * @fn    AddFrame(int x, int y, int width, int height, int bw)
+ * @brief Adds frame to outline
+ *
+ * Adds the four border rectangles of a frame to outline.
+ *
+ * @param x X position of frame
+ * @param y Y position of frame
+ * @param width Outer width of frame
+ * @param height Outer height of frame
+ * @param bw Width of frame border
+ */
+void WaOutline::AddFrame(int x, int y, int width, int height, int bw) {
+    AddRect(x, y, width, bw);
+    AddRect(x, y + height - bw, width, bw);
+    AddRect(x, y + bw, bw, height - bw * 2);
+    AddRect(x + width - bw, y + bw, bw, height - bw * 2);
+}
+
+/**
+ * @fn    Draw(void)
+ * @brief Draws outline
+ *
+ * With shape extension the outline window is reshaped to the current
+ * rectangles with one request. Otherwise one window for each rectangle is
+ * moved into place, windows are created when needed and reused.
+ */
+void WaOutline::Draw(void) {
+    if (! mapped) return;
+
+#ifdef SHAPE
+    if (use_shape) {
+        XShapeCombineRectangles(display, id, ShapeBounding, 0, 0, rects,
+                                n_rects, ShapeSet, Unsorted);
+        if (! parts_mapped) {
+            XMapRaised(display, id);
+            parts_mapped = 1;
+        }
+        return;
+    }
+#endif // SHAPE
+
+    while ((int) parts.size() < n_rects)
+        parts.push_back(CreatePart());
+
+    int i = 0;
+    list<Window>::iterator it = parts.begin();
+    for (; it != parts.end() && (i < n_rects || i < parts_mapped);
+         ++it, i++) {
+        if (i < n_rects) {
+            XMoveResizeWindow(display, *it, rects[i].x, rects[i].y,
+                              rects[i].width, rects[i].height);
+            if (i >= parts_mapped) XMapRaised(display, *it);
+        } else
+            XUnmapWindow(display, *it);
+    }
+    parts_mapped = n_rects;
+}
+
+/**
+ * @fn    Resize(void)
+ * @brief Resizes outline window to screen size
+ */
+void WaOutline::Resize(void) {
+    if (use_shape)
+        XResizeWindow(display, id, wascreen->width, wascreen->height);
+}
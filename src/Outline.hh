@@ -0,0 +1,56 @@
+/**
+ * @file   Outline.hh
+ * @author David Reveman <david@waimea.org>
+ * @date   18-Oct-2026 20:57:26
+ *
+ * @brief Definition of WaOutline class
+ *
+ * Function declarations and variable definitions for WaOutline class.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifndef __Outline_hh
+#define __Outline_hh
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <list>
+using std::list;
+
+class WaOutline;
+
+#include "Screen.hh"
+
+class WaOutline {
+public:
+    WaOutline(WaScreen *);
+    virtual ~WaOutline(void);
+
+    void Map(void);
+    void Unmap(void);
+    void Clear(void);
+    void AddFrame(int, int, int, int, int);
+    void Draw(void);
+    void Resize(void);
+
+    WaScreen *wascreen;
+    Display *display;
+    Window id;
+    bool mapped;
+
+private:
+    void AddRect(int, int, int, int);
+    Window CreatePart(void);
+
+    bool use_shape;
+    XRectangle *rects;
+    int n_rects, max_rects;
+    list<Window> parts;
+    int parts_mapped;
+};
+
+#endif // __Outline_hh
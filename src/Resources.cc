@@ -71,6 +71,7 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
 
     waimea = wa;
     display = waimea->display;
+    XDisplayKeycodes(display, &min_key, &max_key);
 
     homedir = getenv("HOME");
 
@@ -213,6 +214,14 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
                                 &WaWindow::PartAllDesktopsExceptCurrent));
     wacts.push_back(new StrComp("partcurrentjoindesktop",
                                 &WaWindow::PartCurrentJoinDesktop));
+    wacts.push_back(new StrComp("groupraise", &WaWindow::GroupRaise));
+    wacts.push_back(new StrComp("grouplower", &WaWindow::GroupLower));
+    wacts.push_back(new StrComp("groupminimize", &WaWindow::GroupMinimize));
+    wacts.push_back(new StrComp("groupunminimize",
+                                &WaWindow::GroupUnMinimize));
+    wacts.push_back(new StrComp("groupclose", &WaWindow::GroupClose));
+    wacts.push_back(new StrComp("grouppartcurrentjoindesktop",
+                                &WaWindow::GroupPartCurrentJoinDesktop));
     wacts.push_back(new StrComp("mergewithwindow",
                                 &WaWindow::CloneMergeWithWindow));
     wacts.push_back(new StrComp("vertmergewithwindow",
@@ -227,6 +236,12 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
     wacts.push_back(new StrComp("prevmergemode", &WaWindow::PrevMergeMode));
     wacts.push_back(new StrComp("restart", &WaWindow::Restart));
     wacts.push_back(new StrComp("exit", &WaWindow::Exit));
+    wacts.push_back(new StrComp("joindesktopmatch",
+                                &WaWindow::JoinDesktopMatch));
+    wacts.push_back(new StrComp("partdesktopmatch",
+                                &WaWindow::PartDesktopMatch));
+    wacts.push_back(new StrComp("desktopmaskmatch",
+                                &WaWindow::DesktopMaskMatch));
     wacts.push_back(new StrComp("nop", &WaWindow::Nop));
 
     racts.push_back(new StrComp("focus", &WaScreen::Focus));
@@ -263,6 +278,12 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
     racts.push_back(new StrComp("nextdesktop", &WaScreen::NextDesktop));
     racts.push_back(new StrComp("previousdesktop",
                                 &WaScreen::PreviousDesktop));
+    racts.push_back(new StrComp("joindesktopmatch",
+                                &WaScreen::JoinDesktopMatch));
+    racts.push_back(new StrComp("partdesktopmatch",
+                                &WaScreen::PartDesktopMatch));
+    racts.push_back(new StrComp("desktopmaskmatch",
+                                &WaScreen::DesktopMaskMatch));
     racts.push_back(new StrComp("nop", &WaScreen::Nop));
 
     macts.push_back(new StrComp("unlink", &WaMenuItem::UnLinkMenu));
@@ -324,6 +345,12 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
                                 &WaMenuItem::PreviousDesktop));
     macts.push_back(new StrComp("restart", &WaMenuItem::Restart));
     macts.push_back(new StrComp("exit", &WaMenuItem::Exit));
+    macts.push_back(new StrComp("joindesktopmatch",
+                                &WaMenuItem::JoinDesktopMatch));
+    macts.push_back(new StrComp("partdesktopmatch",
+                                &WaMenuItem::PartDesktopMatch));
+    macts.push_back(new StrComp("desktopmaskmatch",
+                                &WaMenuItem::DesktopMaskMatch));
     macts.push_back(new StrComp("nop", &WaMenuItem::Nop));
 
     types.push_back(new StrComp("keypress", KeyPress));
@@ -331,6 +358,9 @@ ResourceHandler::ResourceHandler(Waimea *wa, struct waoptions *options) {
     types.push_back(new StrComp("buttonpress", ButtonPress));
     types.push_back(new StrComp("buttonrelease", ButtonRelease));
     types.push_back(new StrComp("doubleclick", DoubleClick));
+    types.push_back(new StrComp("tripleclick", TripleClick));
+    types.push_back(new StrComp("buttonhold", ButtonHold));
+    types.push_back(new StrComp("buttondrag", ButtonDrag));
     types.push_back(new StrComp("enternotify", EnterNotify));
     types.push_back(new StrComp("leavenotify", LeaveNotify));
     types.push_back(new StrComp("maprequest", MapRequest));
@@ -470,6 +500,40 @@ void ResourceHandler::LoadConfig(Waimea *waimea) {
 
     if (waimea->double_click > 999) waimea->double_click = 999;
 
+    sprintf(rc_name, "holdInterval");
+    sprintf(rc_class, "HoldInterval");
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%lu", &waimea->hold_time) != 1)
+            waimea->hold_time = 500;
+    } else
+        waimea->hold_time = 500;
+
+    sprintf(rc_name, "dragThreshold");
+    sprintf(rc_class, "DragThreshold");
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%d", &waimea->drag_threshold) != 1)
+            waimea->drag_threshold = 4;
+    } else
+        waimea->drag_threshold = 4;
+
+    if (waimea->drag_threshold < 1) waimea->drag_threshold = 1;
+
+    sprintf(rc_name, "keySequenceTimeout");
+    sprintf(rc_class, "KeySequenceTimeout");
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%lu", &waimea->key_sequence_timeout) != 1)
+            waimea->key_sequence_timeout = 1000;
+    } else
+        waimea->key_sequence_timeout = 1000;
+
+    sprintf(rc_name, "requestRate");
+    sprintf(rc_class, "RequestRate");
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%lu", &waimea->request_rate) != 1)
+            waimea->request_rate = 200;
+    } else
+        waimea->request_rate = 200;
+
     XrmDestroyDatabase(database);
 }
 
@@ -513,6 +577,12 @@ void ResourceHandler::LoadConfig(WaScreen *wascreen) {
         }
     }
 
+    sc->rules_file = NULL;
+    sprintf(rc_name, "screen%d.rulesFile", sn);
+    sprintf(rc_class, "Screen%d.RulesFile", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value))
+        sc->rules_file = environment_expansion(__m_wastrdup(value.addr));
+
     sc->menu_file = __m_wastrdup(menu_file);
     if (! menu_forced) {
         sprintf(rc_name, "screen%d.menuFile", sn);
@@ -535,6 +605,26 @@ void ResourceHandler::LoadConfig(WaScreen *wascreen) {
     } else
         sc->desktops = 1;
 
+#ifdef PIXMAP
+    char *background = NULL;
+    sprintf(rc_name, "screen%d.background", sn);
+    sprintf(rc_class, "Screen%d.Background", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value))
+        background = value.addr;
+    for (unsigned int i = 0; i < sc->desktops; i++) {
+        sprintf(rc_name, "screen%d.desktop%u.background", sn, i);
+        sprintf(rc_class, "Screen%d.Desktop%u.Background", sn, i);
+        if (XrmGetResource(database, rc_name, rc_class, &value_type, &value))
+            sc->backgrounds[i] =
+                environment_expansion(__m_wastrdup(value.addr));
+        else if (background)
+            sc->backgrounds[i] =
+                environment_expansion(__m_wastrdup(background));
+        else
+            sc->backgrounds[i] = NULL;
+    }
+#endif // PIXMAP
+
     sprintf(rc_name, "screen%d.desktopNames", sn);
     sprintf(rc_class, "Screen%d.DesktopNames", sn);
     if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
@@ -596,6 +686,24 @@ void ResourceHandler::LoadConfig(WaScreen *wascreen) {
     } else
         sc->cache_max = 200;
 
+    sprintf(rc_name, "screen%d.snapDistance", sn);
+    sprintf(rc_class, "Screen%d.SnapDistance", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%d", &sc->snap_distance) != 1 ||
+            sc->snap_distance < 0)
+            sc->snap_distance = 0;
+    } else
+        sc->snap_distance = 0;
+
+    sprintf(rc_name, "screen%d.edgeResistance", sn);
+    sprintf(rc_class, "Screen%d.EdgeResistance", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%d", &sc->edge_resistance) != 1 ||
+            sc->edge_resistance < 0)
+            sc->edge_resistance = 0;
+    } else
+        sc->edge_resistance = 0;
+
     sprintf(rc_name, "screen%d.imageDither", sn);
     sprintf(rc_class, "screen%d.ImageDither", sn);
     if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
@@ -1181,7 +1289,7 @@ void ResourceHandler::LoadStyle(WaScreen *wascreen) {
 
     if (XrmGetResource(database, "rootCommand", "RootCommand",
                        &value_type, &value))
-        waexec(value.addr, wascreen->displaystring);
+        waexec(value.addr, wascreen);
 
     int num = 0;
     char rc_name[50], rc_class[50];
@@ -1718,6 +1826,193 @@ void ResourceHandler::LoadActions(WaScreen *wascreen) {
     }
 }
 
+/**
+ * @fn    LoadRules(WaScreen *wascreen)
+ * @brief Reads window rules
+ *
+ * Reads window rules file. Each rule starts with a window match in the
+ * same form as individual action lists, followed by a block of rule
+ * settings.
+ *
+ * @param wascreen WaScreen to read rules for
+ */
+void ResourceHandler::LoadRules(WaScreen *wascreen) {
+    ScreenConfig *sc = &wascreen->config;
+    FILE *file;
+    int i, ret;
+    char buffer[8192];
+    char buffer2[8192];
+
+    if (! sc->rules_file) return;
+
+    if (! (file = fopen(sc->rules_file, "r"))) {
+        WARNING << "can't open rules file `" << sc->rules_file <<
+            "' for reading" << endl;
+        return;
+    }
+    for (;;) {
+        for (i = 0; i < 8191 && (ret = fgetc(file)) != EOF &&
+                 ret != '{'; i++) {
+            buffer[i] = ret;
+            if (buffer[i] == '#' || buffer[i] == '!') {
+                i--;
+                while ((ret = fgetc(file)) != EOF && ret != '\n');
+            }
+        }
+        if (ret != '{') break;
+        buffer[i] = '\0';
+
+        for (i = 0; i < 8191 && (ret = fgetc(file)) != EOF &&
+                 ret != '}'; i++) {
+            buffer2[i] = ret;
+            if (buffer2[i] == '#' || buffer2[i] == '!') {
+                i--;
+                while ((ret = fgetc(file)) != EOF && ret != '\n');
+            }
+        }
+        buffer2[i] = '\0';
+        if (ret != '}') {
+            ERROR << "missing '}'" << endl;
+            break;
+        }
+        ParseRule(strtrim(buffer), buffer2, wascreen);
+    }
+    fclose(file);
+}
+
+/**
+ * @fn    rulebool(char *s)
+ * @brief Parses rule boolean
+ *
+ * @param s String to parse
+ *
+ * @return 1 for true, 0 for false and -1 if string isn't a boolean
+ */
+static int rulebool(char *s) {
+    if (! strcasecmp(s, "on") || ! strcasecmp(s, "true") ||
+        ! strcasecmp(s, "yes"))
+        return 1;
+    if (! strcasecmp(s, "off") || ! strcasecmp(s, "false") ||
+        ! strcasecmp(s, "no"))
+        return 0;
+    WARNING << "`" << s << "' is not a boolean" << endl;
+    return -1;
+}
+
+/**
+ * @fn    ParseRule(char *match, char *s, WaScreen *wascreen)
+ * @brief Parses a window rule
+ *
+ * Creates a window rule from window match string and block of comma
+ * separated rule settings.
+ *
+ * @param match Window match string
+ * @param s Rule settings
+ * @param wascreen WaScreen to add rule to
+ */
+void ResourceHandler::ParseRule(char *match, char *s, WaScreen *wascreen) {
+    char *n = NULL, *c = NULL, *t = NULL, *token, *value, *end;
+    char *__m_wastrdup_tmp;
+    long desktop, mask;
+
+    int len = strlen(match);
+    if (len < 3 || match[1] != '/' || match[len - 1] != '/') {
+        WARNING << "bad window match: " << match << endl;
+        return;
+    }
+    match[len - 1] = '\0';
+    switch (*match) {
+        case 'n': n = match + 2; break;
+        case 'c': c = match + 2; break;
+        case 't': t = match + 2; break;
+        default:
+            WARNING << "bad window match: " << match << endl;
+            return;
+    }
+    WaWindowRule *rule = new WaWindowRule(n, c, t);
+
+    for (token = strtok(s, ","); token; token = strtok(NULL, ",")) {
+        if (! (value = strchr(token, '='))) {
+            if (*strtrim(token))
+                WARNING << "missing '=' in rule `" << strtrim(token) <<
+                    "'" << endl;
+            continue;
+        }
+        *value++ = '\0';
+        token = strtrim(token);
+        value = strtrim(value);
+
+        if (! strcasecmp(token, "desktop")) {
+            if (! strcasecmp(value, "all"))
+                rule->desktop_mask = ((1L << 16) - 1);
+            else {
+                desktop = strtol(value, &end, 10);
+                if (end == value || *end != '\0' || desktop < 0 ||
+                    desktop >= (long) wascreen->config.desktops)
+                    WARNING << "bad desktop `" << value << "'" << endl;
+                else
+                    rule->desktop_mask = (1L << desktop);
+            }
+        }
+        else if (! strcasecmp(token, "desktopmask")) {
+            mask = strtol(value, &end, 0);
+            if (end == value || *end != '\0' || mask <= 0 ||
+                mask >= (1L << wascreen->config.desktops))
+                WARNING << "bad desktopmask `" << value << "'" << endl;
+            else
+                rule->desktop_mask = mask;
+        }
+        else if (! strcasecmp(token, "geometry"))
+            rule->geometry = XParseGeometry(value, &rule->x, &rule->y,
+                                            &rule->width, &rule->height);
+        else if (! strcasecmp(token, "decor"))
+            rule->decor_title = rule->decor_handle = rule->decor_border =
+                rulebool(value);
+        else if (! strcasecmp(token, "title"))
+            rule->decor_title = rulebool(value);
+        else if (! strcasecmp(token, "handle"))
+            rule->decor_handle = rulebool(value);
+        else if (! strcasecmp(token, "border"))
+            rule->decor_border = rulebool(value);
+        else if (! strcasecmp(token, "sticky"))
+            rule->sticky = rulebool(value);
+        else if (! strcasecmp(token, "shaded"))
+            rule->shaded = rulebool(value);
+        else if (! strcasecmp(token, "tasklist"))
+            rule->tasklist = rulebool(value);
+        else if (! strcasecmp(token, "focusable"))
+            rule->focusable = rulebool(value);
+        else if (! strcasecmp(token, "layer")) {
+            if (! strcasecmp(value, "alwaysontop"))
+                rule->layer = AlwaysontopLayer;
+            else if (! strcasecmp(value, "alwaysatbottom"))
+                rule->layer = AlwaysatbottomLayer;
+            else if (! strcasecmp(value, "normal"))
+                rule->layer = NormalLayer;
+            else
+                WARNING << "bad layer `" << value << "'" << endl;
+        }
+        else if (! strcasecmp(token, "merge")) {
+            if (! strncasecmp(value, "vert", 4))
+                rule->mergetype = VertMergeType;
+            else if (! strncasecmp(value, "horiz", 5))
+                rule->mergetype = HorizMergeType;
+            else if (! strncasecmp(value, "clone", 5))
+                rule->mergetype = CloneMergeType;
+            else {
+                WARNING << "bad merge type `" << value << "'" << endl;
+                continue;
+            }
+            while (*value && ! isspace(*value)) value++;
+            if (rule->merge) delete [] rule->merge;
+            rule->merge = __m_wastrdup(strtrim(value));
+        }
+        else
+            WARNING << "unknown rule `" << token << "'" << endl;
+    }
+    wascreen->config.rules.push_back(rule);
+}
+
 /**
  * @fn    ReadActions(char *s,
  *                    list<Define *> *defs,
@@ -1807,7 +2102,7 @@ void ResourceHandler::ReadDatabaseColor(const char *rname, const char *rclass,
         ic->parseColor(color, value.addr);
     } else {
         ic->parseColor(color);
-        color->setPixel(default_pixel);
+        color->setPixel(default_pixel | ic->getAlphaMask());
     }
 
     int clen = strlen(rclass) + 9, nlen = strlen(rname) + 9;
@@ -1979,7 +2274,7 @@ void ResourceHandler::ReadDatabaseTexture(const char *rname, const char *rclass,
             if (! XAllocColor(display, colormap, &xcol))
                 xcol.pixel = 0;
 
-            texture->getHiColor()->setPixel(xcol.pixel);
+            texture->getHiColor()->setPixel(xcol.pixel | ic->getAlphaMask());
 
             xcol.red =
                 (unsigned int) ((texture->getColor()->getRed() >> 2) +
@@ -1995,7 +2290,7 @@ void ResourceHandler::ReadDatabaseTexture(const char *rname, const char *rclass,
             if (! XAllocColor(display, colormap, &xcol))
                 xcol.pixel = 0;
 
-            texture->getLoColor()->setPixel(xcol.pixel);
+            texture->getLoColor()->setPixel(xcol.pixel | ic->getAlphaMask());
         }
     } else if (texture->getTexture() & WaImage_Gradient) {
         int clen = strlen(rclass) + 10, nlen = strlen(rname) + 10;
@@ -2074,7 +2369,7 @@ void ResourceHandler::ReadDatabaseTexture(const char *rname, const char *rclass,
                              0, 0, 1, 1);
         texture->setAlphaPicture(alphaPicture);
         XFreePixmap(ic->getDisplay(), alphaPixmap);
-        if (texture->getTexture() == (WaImage_Solid | WaImage_Flat)) {
+        if (texture->getTexture() & WaImage_Solid) {
             Rpf.depth = ic->getDepth();
             xformat = XRenderFindFormat(ic->getDisplay(), PictFormatType |
                                         PictFormatDepth,
@@ -2156,7 +2451,7 @@ void ResourceHandler::ReadDatabaseFont(const char *rname, const char *rclass,
 void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
                                   list<WaAction *> *insert,
                                   WaScreen *wascreen) {
-    char *line, *token, *par, *tmp_par;
+    char *line, *token, *par, *tmp_par, *strokes;
     int i, detail, mod;
     WaAction *act_tmp;
     KeySym keysym;
@@ -2164,15 +2459,16 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
     char *__m_wastrdup_tmp;
     char *s = NULL;
 
-    int min_key, max_key;
-    XDisplayKeycodes(wascreen->display, &min_key, &max_key);
-
     act_tmp = new WaAction;
+    act_tmp->keysym = NoSymbol;
     act_tmp->replay = false;
     act_tmp->delay.tv_sec = act_tmp->delay.tv_usec = 0;
     act_tmp->delay_breaks = NULL;
+    act_tmp->seq = NULL;
 
     line = __m_wastrdup((char *) _s);
+    if ((strokes = strchr(line, ':')) && (strokes = strchr(strokes, '>')))
+        *(strokes++) = '\0';
 
     detail = strchr(line, '=') ? 1: 0;
     mod    = strchr(line, '&') ? 1: 0;
@@ -2255,7 +2551,10 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
             act_tmp->winfunc == (WwActionFn) &WaWindow::HorizMergeWithWindow ||
             act_tmp->winfunc == (WwActionFn)
             &WaWindow::CloneMergeWithWindow ||
-            act_tmp->winfunc == (WwActionFn) &WaWindow::SetMergeMode)) {
+            act_tmp->winfunc == (WwActionFn) &WaWindow::SetMergeMode ||
+            act_tmp->winfunc == (WwActionFn) &WaWindow::JoinDesktopMatch ||
+            act_tmp->winfunc == (WwActionFn) &WaWindow::PartDesktopMatch ||
+            act_tmp->winfunc == (WwActionFn) &WaWindow::DesktopMaskMatch)) {
             WARNING "`" << token << "' action must have a parameter" <<
                 endl;
             delete act_tmp;
@@ -2276,7 +2575,13 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
             act_tmp->rootfunc == (RootActionFn)
             &WaScreen::ViewportRelativeMove ||
             act_tmp->rootfunc == (RootActionFn) &WaScreen::ViewportFixedMove ||
-            act_tmp->rootfunc == (RootActionFn) &WaScreen::GoToDesktop)) {
+            act_tmp->rootfunc == (RootActionFn) &WaScreen::GoToDesktop ||
+            act_tmp->rootfunc == (RootActionFn)
+            &WaScreen::JoinDesktopMatch ||
+            act_tmp->rootfunc == (RootActionFn)
+            &WaScreen::PartDesktopMatch ||
+            act_tmp->rootfunc == (RootActionFn)
+            &WaScreen::DesktopMaskMatch)) {
             WARNING "`" << token << "' action must have a parameter" <<
                 endl;
             delete act_tmp;
@@ -2300,7 +2605,13 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
             &WaMenuItem::ViewportRelativeMove ||
             act_tmp->menufunc == (MenuActionFn)
             &WaMenuItem::ViewportFixedMove ||
-            act_tmp->menufunc == (MenuActionFn) &WaMenuItem::GoToDesktop)) {
+            act_tmp->menufunc == (MenuActionFn) &WaMenuItem::GoToDesktop ||
+            act_tmp->menufunc == (MenuActionFn)
+            &WaMenuItem::JoinDesktopMatch ||
+            act_tmp->menufunc == (MenuActionFn)
+            &WaMenuItem::PartDesktopMatch ||
+            act_tmp->menufunc == (MenuActionFn)
+            &WaMenuItem::DesktopMaskMatch)) {
             WARNING "`" << token << "' action must have a parameter" <<
                 endl;
             delete act_tmp;
@@ -2356,9 +2667,9 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
                     if (s) delete [] s; s = NULL;
                     return;
                 } else {
-                    act_tmp->detail = XKeysymToKeycode(display, keysym);
-                    if (act_tmp->detail < (unsigned int) min_key ||
-                        act_tmp->detail > (unsigned int) max_key) {
+                    act_tmp->keysym = keysym;
+                    act_tmp->detail = Keycode(keysym);
+                    if (! act_tmp->detail) {
                         WARNING << "`" << token << "' bad keycode" << endl;
                         delete act_tmp;
                         delete [] line;
@@ -2369,7 +2680,10 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
             }
         } else if (act_tmp->type == ButtonPress ||
                    act_tmp->type == ButtonRelease ||
-                   act_tmp->type == DoubleClick) {
+                   act_tmp->type == DoubleClick ||
+                   act_tmp->type == TripleClick ||
+                   act_tmp->type == ButtonHold ||
+                   act_tmp->type == ButtonDrag) {
             it = bdetails.begin();
             for (; it != bdetails.end(); ++it) {
                 if ((*it)->Comp(token)) {
@@ -2442,11 +2756,207 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
             }
         }
     }
+    if (strokes) {
+        if (! ParseKeySequence(act_tmp, strokes, insert, wascreen)) {
+            if (act_tmp->exec) delete [] act_tmp->exec;
+            if (act_tmp->param) delete [] act_tmp->param;
+            if (act_tmp->delay_breaks) delete act_tmp->delay_breaks;
+            delete act_tmp;
+        }
+        delete [] line;
+        if (s) delete [] s;
+        s = NULL;
+        return;
+    }
     delete [] line;
     insert->push_back(act_tmp);
+    if (act_tmp->keysym != NoSymbol)
+        wascreen->config.keyacts.push_back(act_tmp);
     if (s) delete [] s; s = NULL;
 }
 
+/**
+ * @fn    ParseKeySequence(WaAction *act, char *strokes,
+ *                         list<WaAction *> *insert, WaScreen *wascreen)
+ * @brief Parses key sequence of an action line
+ *
+ * Parses the '>' separated key strokes that follow the first key stroke of
+ * an action line. All sequences in an action list starting with the same
+ * key stroke share one prefix action, which holds a trie of the following
+ * key strokes. The parsed action is stored in the trie node of its last key
+ * stroke. A sequence that is a prefix of another sequence in the same
+ * action list is rejected, as a trie node can't both complete a sequence
+ * and continue it.
+ *
+ * @param act Parsed action, its event description is the first key stroke
+ * @param strokes Key strokes following the first key stroke
+ * @param insert List to insert prefix action in
+ * @param wascreen WaScreen to parse action for
+ *
+ * @return True if key sequence was parsed successfully, otherwise false
+ */
+bool ResourceHandler::ParseKeySequence(WaAction *act, char *strokes,
+                                       list<WaAction *> *insert,
+                                       WaScreen *wascreen) {
+    KeySym keysyms[MaxKeySequence], upper;
+    unsigned int smods[MaxKeySequence], snmods[MaxKeySequence];
+    char *stroke, *end, *token;
+    int i, n = 0;
+    bool negative;
+    list<StrComp *>::iterator it;
+
+    if (act->type != KeyPress || act->keysym == NoSymbol) {
+        WARNING << "key sequence must start with a KeyPress event for " <<
+            "a key" << endl;
+        return false;
+    }
+    for (stroke = strokes; stroke; stroke = end) {
+        if ((end = strchr(stroke, '>'))) *(end++) = '\0';
+        if (n == MaxKeySequence) {
+            WARNING << "key sequence with more than " << MaxKeySequence <<
+                " key strokes" << endl;
+            return false;
+        }
+        smods[n] = snmods[n] = 0;
+        token = strtok(stroke, "&");
+        token = strtrim(token ? token: stroke);
+        if ((keysyms[n] = XStringToKeysym(token)) == NoSymbol) {
+            WARNING << "`" << token << "' unknown key" << endl;
+            return false;
+        }
+        XConvertCase(keysyms[n], &keysyms[n], &upper);
+        while ((token = strtok(NULL, "&"))) {
+            token = strtrim(token);
+            negative = false;
+            if (*token == '!') {
+                negative = true;
+                token = strtrim(token + 1);
+            }
+            for (it = mods.begin(); it != mods.end(); ++it) {
+                if ((*it)->Comp(token)) {
+                    if (negative)
+                        snmods[n] |= (*it)->value;
+                    else
+                        smods[n] |= (*it)->value;
+                    break;
+                }
+            }
+            if (! *it) {
+                WARNING << "`" << token << "' unknown modifier " <<
+                    "or bad modifier key" << endl;
+                return false;
+            }
+        }
+        n++;
+    }
+
+    WaAction *prefix = NULL;
+    KeySequence *node;
+    list<WaAction *>::iterator ait = insert->begin();
+    for (; ait != insert->end(); ++ait) {
+        if ((*ait)->seq && (*ait)->keysym == act->keysym &&
+            (*ait)->mod == act->mod && (*ait)->nmod == act->nmod) {
+            prefix = *ait;
+            break;
+        }
+    }
+    if (prefix) {
+        node = prefix->seq;
+        for (i = 0; node && i < n; i++) {
+            node = node->Find(keysyms[i], smods[i], snmods[i]);
+            if (node && ((i < n - 1 && ! node->acts.empty()) ||
+                         (i == n - 1 && ! node->next.empty()))) {
+                WARNING << "key sequence conflicts with key sequence " <<
+                    "sharing its key strokes" << endl;
+                return false;
+            }
+        }
+    }
+    if (! prefix) {
+        prefix = new WaAction;
+        *prefix = *act;
+        prefix->winfunc = NULL;
+        prefix->rootfunc = NULL;
+        prefix->menufunc = NULL;
+        prefix->exec = prefix->param = NULL;
+        prefix->delay.tv_sec = prefix->delay.tv_usec = 0;
+        prefix->delay_breaks = NULL;
+        prefix->seq = new KeySequence(act->mod, act->nmod);
+        insert->push_back(prefix);
+        wascreen->config.keyacts.push_back(prefix);
+    }
+
+    node = prefix->seq;
+    for (i = 0; i < n; i++)
+        node = node->Insert(keysyms[i], smods[i], snmods[i]);
+    act->keysym = NoSymbol;
+    act->detail = 0;
+    node->acts.push_back(act);
+
+    return true;
+}
+
+/**
+ * @fn    Keycode(KeySym keysym)
+ * @brief Keycode for keysym
+ *
+ * Looks up keycode for keysym in keycode cache, cache is filled the
+ * first time a keysym is used.
+ *
+ * @param keysym Keysym to get keycode for
+ *
+ * @return Keycode for keysym or 0 if keysym isn't bound to a valid keycode
+ */
+unsigned int ResourceHandler::Keycode(KeySym keysym) {
+    map<KeySym, unsigned int>::iterator it = keycodes.find(keysym);
+    if (it != keycodes.end()) return it->second;
+
+    unsigned int keycode = XKeysymToKeycode(display, keysym);
+    if (keycode < (unsigned int) min_key || keycode > (unsigned int) max_key)
+        keycode = 0;
+    keycodes[keysym] = keycode;
+
+    return keycode;
+}
+
+/**
+ * @fn    UpdateKeycodes(void)
+ * @brief Update keycodes after keyboard mapping change
+ *
+ * Resolves all cached keysyms again. Key actions which keysym got a new
+ * keycode are updated and only the passive grabs for those keycodes are
+ * changed.
+ */
+void ResourceHandler::UpdateKeycodes(void) {
+    map<KeySym, unsigned int> changed;
+
+    XDisplayKeycodes(display, &min_key, &max_key);
+    map<KeySym, unsigned int>::iterator kit = keycodes.begin();
+    for (; kit != keycodes.end(); ++kit) {
+        unsigned int keycode = XKeysymToKeycode(display, kit->first);
+        if (keycode < (unsigned int) min_key ||
+            keycode > (unsigned int) max_key)
+            keycode = 0;
+        if (keycode != kit->second) {
+            changed[kit->first] = kit->second;
+            kit->second = keycode;
+        }
+    }
+    if (changed.empty()) return;
+
+    list<WaScreen *>::iterator sit = waimea->wascreen_list.begin();
+    for (; sit != waimea->wascreen_list.end(); ++sit) {
+        list<WaAction *>::iterator ait = (*sit)->config.keyacts.begin();
+        for (; ait != (*sit)->config.keyacts.end(); ++ait)
+            if (changed.find((*ait)->keysym) != changed.end())
+                (*ait)->detail = keycodes[(*ait)->keysym];
+
+        list<WaWindow *>::iterator wit = (*sit)->wawindow_list.begin();
+        for (; wit != (*sit)->wawindow_list.end(); ++wit)
+            (*wit)->UpdateKeyGrabs(&changed);
+    }
+}
+
 /**
  * @fn    ParseMenu(WaMenu *menu, FILE *file, WaScreen *wascreen)
  * @brief Parses a menu file
@@ -2454,7 +2964,10 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
  * Parses a menu section of the menu file and creates a menu object for the
  * menu. If a [start] or [begin] statement is found when parsing a menu, we
  * make a recursive function call to this function. This makes it possible to
- * to define a submenu within a the menu itself.
+ * to define a submenu within a the menu itself. An @ICON (file) part at the
+ * end of an item line sets the icon file for the item, icon files aren't
+ * read until the menu is mapped. @ICON is only searched for outside of
+ * the tag, title, exec and submenu fields, so it can be part of a command.
  *
  * @param menu Menu to add items to
  * @param file File descriptor for menu file
@@ -2465,7 +2978,7 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
 WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
                                    WaScreen *wascreen) {
     char *s = NULL, line[8192], *line1 = NULL, *line2 = NULL,
-        *par = NULL, *tmp_par = NULL;
+        *par = NULL, *tmp_par = NULL, *icon = NULL, field_end;
     WaMenuItem *m;
     int i, type, cb;
     WaMenu *tmp_menu;
@@ -2481,6 +2994,27 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
 
         cb = 0;
 
+        if (icon) delete [] icon;
+        icon = NULL;
+        for (i = 0, field_end = '\0'; line[i] != '\0'; i++) {
+            if (i && line[i - 1] == '\\') continue;
+            if (field_end) {
+                if (line[i] == field_end) field_end = '\0';
+                continue;
+            }
+            switch (line[i]) {
+                case '[': field_end = ']'; break;
+                case '(': field_end = ')'; break;
+                case '{': field_end = '}'; break;
+                case '<': field_end = '>'; break;
+            }
+            if (! field_end && ! strncasecmp(&line[i], "@ICON", 5)) break;
+        }
+        if (line[i] != '\0') {
+            icon = strwithin(&line[i + 5], '(', ')', true);
+            line[i] = '\0';
+        }
+
         if (s) delete [] s; s = NULL;
         if (! (s = strwithin(line, '[', ']'))) {
             WARNING << "(" << basename(menu_file) << ":" << linenr << "):" <<
@@ -2548,6 +3082,7 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
                     m->func_mask |= MenuSubMask;
                     m->func_mask1 |= MenuSubMask;
                     m->sub = m->sub1 = __m_wastrdup(s);
+                    m->icon_file = icon; icon = NULL;
                     menu->AddItem(m);
                 }
                 tmp_menu = new WaMenu(s);
@@ -2617,6 +3152,7 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
                     m->func_mask1 |= MenuExecMask;
                 }
             }
+            m->icon_file = icon; icon = NULL;
             menu->AddItem(m);
             continue;
         }
@@ -2627,6 +3163,7 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
             else
                 m = new WaMenuItem("");
             m->type = MenuItemType;
+            m->icon_file = icon; icon = NULL;
             menu->AddItem(m);
             continue;
         }
@@ -2640,6 +3177,7 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
             }
             wascreen->wamenu_list.push_back(menu);
             if (s) delete [] s; s = NULL;
+            if (icon) delete [] icon;
             return menu;
         }
         else if (! strncasecmp(s, "checkbox", 8)) {
@@ -2882,8 +3420,10 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
                 }
             }
         }
+        m->icon_file = icon; icon = NULL;
         menu->AddItem(m);
     }
+    if (icon) delete [] icon;
     if (menu) {
         if (menu->item_list.empty()) {
             WARNING << "no elements in menu `" << menu->name <<
@@ -2936,6 +3476,100 @@ bool StrComp::Comp(char *s) {
     return false;
 }
 
+/**
+ * @fn    KeySequence(unsigned int m, unsigned int nm)
+ * @brief Constructor for KeySequence class
+ *
+ * Creates a key sequence trie node.
+ *
+ * @param m Modifiers that must be active for key stroke
+ * @param nm Modifiers that must not be active for key stroke
+ */
+KeySequence::KeySequence(unsigned int m, unsigned int nm) {
+    mod = m;
+    nmod = nm;
+}
+
+/**
+ * @fn    ~KeySequence(void)
+ * @brief Destructor for KeySequence class
+ *
+ * Deletes all following trie nodes and actions.
+ */
+KeySequence::~KeySequence(void) {
+    map<KeySym, list<KeySequence *> >::iterator it = next.begin();
+    for (; it != next.end(); ++it)
+        LISTDEL(it->second);
+    ACTLISTCLEAR(acts);
+}
+
+/**
+ * @fn    Find(KeySym keysym, unsigned int m, unsigned int nm)
+ * @brief Find key stroke
+ *
+ * @param keysym Keysym of key stroke
+ * @param m Modifiers that must be active for key stroke
+ * @param nm Modifiers that must not be active for key stroke
+ *
+ * @return Trie node for key stroke, NULL if it doesn't exist
+ */
+KeySequence *KeySequence::Find(KeySym keysym, unsigned int m,
+                               unsigned int nm) {
+    map<KeySym, list<KeySequence *> >::iterator it = next.find(keysym);
+    if (it == next.end()) return NULL;
+
+    list<KeySequence *>::iterator nit = it->second.begin();
+    for (; nit != it->second.end(); ++nit)
+        if ((*nit)->mod == m && (*nit)->nmod == nm) return *nit;
+
+    return NULL;
+}
+
+/**
+ * @fn    Insert(KeySym keysym, unsigned int m, unsigned int nm)
+ * @brief Insert key stroke
+ *
+ * Returns following trie node for key stroke, node is created if it
+ * doesn't exist.
+ *
+ * @param keysym Keysym of key stroke
+ * @param m Modifiers that must be active for key stroke
+ * @param nm Modifiers that must not be active for key stroke
+ *
+ * @return Trie node for key stroke
+ */
+KeySequence *KeySequence::Insert(KeySym keysym, unsigned int m,
+                                 unsigned int nm) {
+    KeySequence *node = Find(keysym, m, nm);
+    if (node) return node;
+
+    node = new KeySequence(m, nm);
+    next[keysym].push_back(node);
+
+    return node;
+}
+
+/**
+ * @fn    Next(KeySym keysym, unsigned int state)
+ * @brief Advance one key stroke
+ *
+ * @param keysym Keysym of pressed key
+ * @param state Modifier state of key press
+ *
+ * @return Following trie node matching key stroke, NULL if no match
+ */
+KeySequence *KeySequence::Next(KeySym keysym, unsigned int state) {
+    map<KeySym, list<KeySequence *> >::iterator it = next.find(keysym);
+    if (it == next.end()) return NULL;
+
+    list<KeySequence *>::iterator nit = it->second.begin();
+    for (; nit != it->second.end(); ++nit)
+        if (((*nit)->mod & state) == (*nit)->mod && ! ((*nit)->nmod & state))
+            return *nit;
+
+    return NULL;
+}
+
 /**
  * @fn    strtrim(char *s)
  * @brief Trims a string
@@ -27,6 +27,8 @@ extern "C" {
 class ResourceHandler;
 class Define;
 class WaActionExtList;
+class KeySequence;
+class WaWindowRule;
 class StrComp;
 
 typedef struct _WaAction WaAction;
@@ -46,6 +48,8 @@ typedef struct _ButtonStyle ButtonStyle;
             delete [] list.back()->exec; \
         if (list.back()->param) \
             delete [] list.back()->param; \
+        if (list.back()->seq) \
+            delete list.back()->seq; \
         delete list.back(); \
         list.pop_back(); \
     }
@@ -56,6 +60,8 @@ typedef struct _ButtonStyle ButtonStyle;
             delete [] list->back()->exec; \
         if (list->back()->param) \
             delete [] list->back()->param; \
+        if (list->back()->seq) \
+            delete list->back()->seq; \
         delete list->back(); \
         list->pop_back(); \
     }
@@ -68,9 +74,11 @@ struct _WaAction {
     char *exec;
     char *param;
     unsigned int type, detail, mod, nmod;
+    KeySym keysym;
     bool replay;
     struct timeval delay;
     list<int> *delay_breaks;
+    KeySequence *seq;
 };
 
 typedef struct {
@@ -137,7 +145,10 @@ public:
     void LoadStyle(WaScreen *);
     void LoadMenus(WaScreen *);
     void LoadActions(WaScreen *);
+    void LoadRules(WaScreen *);
     WaMenu *ParseMenu(WaMenu *, FILE *, WaScreen *);
+    unsigned int Keycode(KeySym);
+    void UpdateKeycodes(void);
 
     char *rc_file, *style_file, *menu_file, *action_file;
     bool rc_forced, style_forced, action_forced, menu_forced;
@@ -153,6 +164,9 @@ private:
     void ReadDatabaseFont(const char *, const char *, WaFont *, WaFont *);
     void ParseAction(const char *, list<StrComp *> *, list<WaAction *> *,
                      WaScreen *);
+    bool ParseKeySequence(WaAction *, char *, list<WaAction *> *,
+                          WaScreen *);
+    void ParseRule(char *, char *, WaScreen *);
 
     Waimea *waimea;
     Display *display;
@@ -164,12 +178,30 @@ private:
     list<StrComp *> types;
     list<StrComp *> bdetails;
     list<StrComp *> mods;
+    map<KeySym, unsigned int> keycodes;
+    int min_key, max_key;
 };
 
 #define WindowFuncMask (1L << 0)
 #define RootFuncMask   (1L << 1)
 #define MenuFuncMask   (1L << 2)
 
+#define MaxKeySequence 8
+
+class KeySequence {
+public:
+    KeySequence(unsigned int, unsigned int);
+    virtual ~KeySequence(void);
+
+    KeySequence *Find(KeySym, unsigned int, unsigned int);
+    KeySequence *Insert(KeySym, unsigned int, unsigned int);
+    KeySequence *Next(KeySym, unsigned int);
+
+    unsigned int mod, nmod;
+    list<WaAction *> acts;
+    map<KeySym, list<KeySequence *> > next;
+};
+
 class Define {
 public:
     inline Define(char *n, char *v) {
@@ -202,6 +234,45 @@ public:
     list<WaAction *> alist;
 };
 
+enum {
+    NormalLayer,
+    AlwaysontopLayer,
+    AlwaysatbottomLayer
+};
+
+class WaWindowRule {
+public:
+    inline WaWindowRule(char *n, char *c, char *t) {
+        name = new Regex(n);
+        cl = new Regex(c);
+        title = new Regex(t);
+        desktop_mask = 0;
+        geometry = x = y = 0;
+        width = height = 0;
+        decor_title = decor_handle = decor_border = layer = sticky =
+            shaded = tasklist = focusable = -1;
+        mergetype = 0;
+        merge = NULL;
+    }
+    inline ~WaWindowRule(void) {
+        delete name;
+        delete cl;
+        delete title;
+        if (merge) delete [] merge;
+    }
+
+    Regex *name;
+    Regex *cl;
+    Regex *title;
+    long int desktop_mask;
+    int geometry, x, y;
+    unsigned int width, height;
+    int decor_title, decor_handle, decor_border, layer, sticky, shaded,
+        tasklist, focusable;
+    int mergetype;
+    char *merge;
+};
+
 class StrComp {
 public:
     StrComp(const char *, unsigned long);
@@ -26,6 +26,10 @@ extern "C" {
 #  include <X11/extensions/Xrandr.h>
 #endif // RANDR
 
+#ifdef    HAVE_CTYPE_H
+#  include <ctype.h>
+#endif // HAVE_CTYPE_H
+
 #ifdef    HAVE_STDIO_H
 #  include <stdio.h>
 #endif // HAVE_STDIO_H
@@ -47,6 +51,8 @@ extern "C" {
 #ifdef    HAVE_STRING_H
 #  include <string.h>
 #endif // HAVE_STRING_H
+
+#include <errno.h>
 }
 
 #include <iostream>
@@ -55,6 +61,7 @@ using std::cout;
 using std::endl;
 
 #include "Screen.hh"
+#include "Outline.hh"
 
 /**
  * @fn    WaScreen(Display *d, int scrn_number, Waimea *wa)
@@ -91,10 +98,17 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     rh = wa->rh;
     focus = true;
     shutdown = false;
+    installed_colormap = None;
+    argb_visual = false;
+    alpha_mask = 0;
 
     default_font.xft = false;
     default_font.font = __m_wastrdup("fixed");
 
+#ifdef XFT
+    label_cache.bytes = 0;
+#endif // XFT
+
     XSync(display, false);
     if (! (pdisplay = XOpenDisplay(wa->options->display))) {
         ERROR << "can't open display: " << wa->options->display << endl;
@@ -115,7 +129,8 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     eventmask = SubstructureRedirectMask | StructureNotifyMask |
         PropertyChangeMask | ColormapChangeMask | KeyPressMask |
         KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
-        EnterWindowMask | LeaveWindowMask | FocusChangeMask;
+        ButtonMotionMask | EnterWindowMask | LeaveWindowMask |
+        FocusChangeMask;
 
     sprintf(displaystring, "DISPLAY=%s", DisplayString(display));
     sprintf(displaystring + strlen(displaystring) - 1, "%d", screen_number);
@@ -137,8 +152,14 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     int event_basep, error_basep;
     render_extension =
       XRenderQueryExtension(pdisplay, &event_basep, &error_basep);
+    if (render_extension) SetARGBVisual();
 #endif // RENDER
 
+    // GCs must match depth of decoration pixmaps, which isn't the root
+    // window depth when ARGB visual is used
+    gc_pixmap = XCreatePixmap(display, id, 1, 1, screen_depth);
+    copy_gc = XCreateGC(display, gc_pixmap, 0, NULL);
+
 #ifdef RANDR
     XRRSelectInput(display, id, RRScreenChangeNotifyMask);
 #endif // RANDR
@@ -165,15 +186,26 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
 
     ic = new WaImageControl(pdisplay, this, config.image_dither,
                             config.colors_per_channel, config.cache_max);
-    ic->installRootColormap();
+    if (! argb_visual) ic->installRootColormap();
+
+#ifdef PIXMAP
+    if (argb_visual) {
+        imlib_context_push(imlib_context);
+        imlib_context_set_colormap(colormap);
+        imlib_context_set_visual(ic->getVisual());
+        imlib_context_pop();
+    }
+#endif // PIXMAP
 
     rh->LoadStyle(this);
     rh->LoadActions(this);
+    rh->LoadRules(this);
 
     CreateFonts();
     CreateColors();
     RenderCommonImages();
     XDefineCursor(display, id, waimea->session_cursor);
+    outline = new WaOutline(this);
 
     v_xmax = (config.virtual_x - 1) * width;
     v_ymax = (config.virtual_y - 1) * height;
@@ -194,10 +226,14 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     net->GetDesktopViewPort(this);
     net->SetDesktopViewPort(this);
 
+#ifdef PIXMAP
+    SetDesktopBackground();
+#endif // PIXMAP
+
 #ifdef RENDER
     if (render_extension) {
       net->GetXRootPMapId(this);
-      ic->setXRootPMapId((xrootpmap_id)? true: false);
+      ic->setXRootPMapId((xrootpmap_id || argb_visual)? true: false);
     }
 #endif // RENDER
 
@@ -284,6 +320,7 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
 
     delete [] config.style_file;
     delete [] config.action_file;
+    if (config.rules_file) delete [] config.rules_file;
 }
 
 /**
@@ -299,6 +336,25 @@ WaScreen::~WaScreen(void) {
     net->DeleteSupported(this);
     XDestroyWindow(display, wm_check);
 
+#ifdef PIXMAP
+    bool background = false;
+    list<Desktop *>::iterator dit = desktop_list.begin();
+    for (; dit != desktop_list.end(); ++dit) {
+        if ((*dit)->background != None) {
+            background = true;
+            XFreePixmap(display, (*dit)->background);
+            list<Desktop *>::iterator sit = dit;
+            for (++sit; sit != desktop_list.end(); ++sit)
+                if ((*sit)->background == (*dit)->background)
+                    (*sit)->background = None;
+            (*dit)->background = None;
+        }
+        if (config.backgrounds[(*dit)->number])
+            delete [] config.backgrounds[(*dit)->number];
+    }
+    if (background) net->SetXRootPMapId(this, None);
+#endif // PIXMAP
+
     LISTDEL(docks);
 
     WaWindow **delstack = new WaWindow*[wawindow_list.size()];
@@ -391,11 +447,17 @@ WaScreen::~WaScreen(void) {
     }
     delete [] config.ext_bacts;
 
+    LISTDEL(config.rules);
+
+    delete outline;
     delete west;
     delete east;
     delete north;
     delete south;
     delete ic;
+    XFreeGC(display, copy_gc);
+    XFreePixmap(display, gc_pixmap);
+    if (argb_visual) XFreeColormap(display, colormap);
 
     delete [] config.menu_file;
     delete [] mstyle.bullet;
@@ -410,6 +472,53 @@ WaScreen::~WaScreen(void) {
     waimea->window_table.erase(id);
 }
 
+#ifdef RENDER
+/**
+ * @fn    SetARGBVisual(void)
+ * @brief Selects ARGB visual for decorations
+ *
+ * If a compositing manager owns the _NET_WM_CM_S<n> selection, frames,
+ * menus and docks are created with a 32 bit TrueColor visual that has an
+ * alpha channel. Translucent textures are then rendered once with alpha
+ * values and blended by the compositing manager with whatever is below,
+ * no root window background is sampled. Without compositing manager the
+ * default visual is kept.
+ */
+void WaScreen::SetARGBVisual(void) {
+    char atom_name[32];
+    XVisualInfo templ, *vinfo;
+    int n, i;
+
+    sprintf(atom_name, "_NET_WM_CM_S%d", screen_number);
+    if (XGetSelectionOwner(display, XInternAtom(display, atom_name, false))
+        == None) return;
+
+    templ.screen = screen_number;
+    templ.depth = 32;
+    templ.c_class = TrueColor;
+    if (! (vinfo = XGetVisualInfo(display, VisualScreenMask |
+                                  VisualDepthMask | VisualClassMask,
+                                  &templ, &n)))
+        return;
+
+    for (i = 0; i < n; i++) {
+        XRenderPictFormat *format =
+            XRenderFindVisualFormat(display, vinfo[i].visual);
+        if (format && format->type == PictTypeDirect &&
+            format->direct.alphaMask) {
+            visual = vinfo[i].visual;
+            screen_depth = vinfo[i].depth;
+            colormap = XCreateColormap(display, id, visual, AllocNone);
+            alpha_mask = (unsigned long) format->direct.alphaMask <<
+                format->direct.alpha;
+            argb_visual = true;
+            break;
+        }
+    }
+    XFree(vinfo);
+}
+#endif // RENDER
+
 /**
  * @fn    RaiseWindow(Window win)
  * @brief Raises window
@@ -418,8 +527,9 @@ WaScreen::~WaScreen(void) {
  * layer.
  *
  * @param win Window to raise, win equal to zero will restacks all windows
+ * @param restack False if display stacking shouldn't be updated
  */
-void WaScreen::RaiseWindow(Window win) {
+void WaScreen::RaiseWindow(Window win, bool restack) {
     bool end = false;
 
     list<Window>::iterator it = aot_stacking_list.begin();
@@ -520,7 +630,7 @@ void WaScreen::RaiseWindow(Window win) {
         }
     }
 
-    RestackWindows(win);
+    if (restack) RestackWindows(win);
 }
 
 /**
@@ -531,8 +641,9 @@ void WaScreen::RaiseWindow(Window win) {
  * layer.
  *
  * @param win Window to lower, win equal to zero will restacks all windows
+ * @param restack False if display stacking shouldn't be updated
  */
-void WaScreen::LowerWindow(Window win) {
+void WaScreen::LowerWindow(Window win, bool restack) {
     bool end = false;
 
     list<Window>::iterator it = aot_stacking_list.begin();
@@ -567,7 +678,7 @@ void WaScreen::LowerWindow(Window win) {
         }
     }
 
-    RestackWindows(win);
+    if (restack) RestackWindows(win);
 }
 
 /**
@@ -618,6 +729,91 @@ void WaScreen::RestackWindows(Window win) {
     delete [] stack;
 }
 
+/**
+ * @fn    RaiseGroup(Window leader)
+ * @brief Raises application group
+ *
+ * Raises all frames of windows in application group to the top of their
+ * stacking layers. Relative stacking order within the group is kept and
+ * display stacking is updated once for the whole group.
+ *
+ * @param leader Group leader window
+ */
+void WaScreen::RaiseGroup(Window leader) {
+    list<Window> frames;
+    list<Window> *layers[3] = { &aab_stacking_list, &stacking_list,
+                                &aot_stacking_list };
+
+    for (int i = 0; i < 3; i++) {
+        list<Window>::reverse_iterator it = layers[i]->rbegin();
+        for (; it != layers[i]->rend(); ++it) {
+            WaChildWindow *wc = (WaChildWindow *)
+                waimea->FindWin(*it, FrameType);
+            if (wc && wc->wa->group == leader) frames.push_back(*it);
+        }
+    }
+    if (frames.empty()) return;
+
+    list<Window>::iterator it = frames.begin();
+    for (; it != frames.end(); ++it) RaiseWindow(*it, false);
+    RestackWindows(0);
+    net->SetClientListStacking(this);
+}
+
+/**
+ * @fn    LowerGroup(Window leader)
+ * @brief Lowers application group
+ *
+ * Lowers all frames of windows in application group to the bottom of their
+ * stacking layers. Relative stacking order within the group is kept and
+ * display stacking is updated once for the whole group.
+ *
+ * @param leader Group leader window
+ */
+void WaScreen::LowerGroup(Window leader) {
+    list<Window> frames;
+    list<Window> *layers[3] = { &aot_stacking_list, &stacking_list,
+                                &aab_stacking_list };
+
+    for (int i = 0; i < 3; i++) {
+        list<Window>::iterator it = layers[i]->begin();
+        for (; it != layers[i]->end(); ++it) {
+            WaChildWindow *wc = (WaChildWindow *)
+                waimea->FindWin(*it, FrameType);
+            if (wc && wc->wa->group == leader) frames.push_back(*it);
+        }
+    }
+    if (frames.empty()) return;
+
+    list<Window>::iterator it = frames.begin();
+    for (; it != frames.end(); ++it) LowerWindow(*it, false);
+    RestackWindows(0);
+    net->SetClientListStacking(this);
+}
+
+/**
+ * @fn    GroupMembers(Window leader, list<WaWindow *> *members)
+ * @brief Lists application group
+ *
+ * Adds all windows in application group to members list. Merged windows
+ * are represented by their master window and each window is only added
+ * once.
+ *
+ * @param leader Group leader window
+ * @param members List to add group members to
+ */
+void WaScreen::GroupMembers(Window leader, list<WaWindow *> *members) {
+    map<Window, list<WaWindow *> >::iterator git = groups.find(leader);
+    if (git == groups.end()) return;
+
+    list<WaWindow *>::iterator it = git->second.begin();
+    for (; it != git->second.end(); ++it) {
+        WaWindow *ww = ((*it)->master)? (*it)->master: *it;
+        members->remove(ww);
+        members->push_back(ww);
+    }
+}
+
 /**
  * @fn    UpdateCheckboxes(int type)
  * @brief Updates menu checkboxes
@@ -645,11 +841,41 @@ void WaScreen::UpdateCheckboxes(int type) {
     }
 }
 
+/**
+ * @fn    UpdateIcons(Window id)
+ * @brief Updates menu icons
+ *
+ * Redraws menu items showing the icon of a window after the icon has
+ * changed. Double buffered menus are redrawn as a whole.
+ *
+ * @param id Window with changed icon
+ */
+void WaScreen::UpdateIcons(Window id) {
+    list<WaMenuItem *>::iterator miit;
+
+    list<WaMenu *>::iterator mit = wamenu_list.begin();
+    for (; mit != wamenu_list.end(); ++mit) {
+        if (! (*mit)->mapped || ! (*mit)->icons) continue;
+        miit = (*mit)->item_list.begin();
+        for (; miit != (*mit)->item_list.end(); ++miit) {
+            if ((*miit)->wf != id || (*miit)->icon ||
+                (*miit)->type == MenuTitleType)
+                continue;
+            if ((*mit)->db) {
+                (*mit)->Render();
+                break;
+            }
+            (*miit)->Render();
+        }
+    }
+}
+
 /**
  * @fn    GetMenuNamed(char *menu)
  * @brief Find a menu
  *
  * Searches through menu list after a menu named as 'menu' parameter.
+ * Generated menus found in menu list are regenerated if stale.
  *
  * @param menu menu name to use for search
  *
@@ -664,8 +890,10 @@ WaMenu *WaScreen::GetMenuNamed(char *menu) {
 
     list<WaMenu *>::iterator menu_it = wamenu_list.begin();
     for (; menu_it != wamenu_list.end(); ++menu_it)
-        if (! strcmp((*menu_it)->name, menu))
+        if (! strcmp((*menu_it)->name, menu)) {
+            (*menu_it)->Update();
             return *menu_it;
+        }
 
     for (i = 0; menu[i] != '\0' && menu[i] != '!'; i++);
     if (menu[i] == '!' && menu[i + 1] != '\0') {
@@ -681,7 +909,8 @@ WaMenu *WaScreen::GetMenuNamed(char *menu) {
  * @fn    CreateDynamicMenu(char *name)
  * @brief Creates a dynamic menu
  *
- * Executes command line and parses standard out as a menu file.
+ * Executes command line and parses standard out as a menu file. Command
+ * lines starting with '@' are handled by menu generators.
  *
  * @param name Name of dynamic menu to create
  *
@@ -702,19 +931,20 @@ WaMenu *WaScreen::CreateDynamicMenu(char *name) {
     } else
         return NULL;
 
+    if (**tmp_argv == '@') {
+        dmenu = CreateGeneratedMenu(name, tmp_argv);
+        delete [] allocname;
+        return dmenu;
+    }
+
     if (pipe(m_pipe) < 0) {
         WARNING;
         perror("pipe");
     }
     else {
-        struct sigaction action;
-
-        action.sa_handler = SIG_DFL;
-        action.sa_mask = sigset_t();
-        action.sa_flags = 0;
-        sigaction(SIGCHLD, &action, NULL);
         pid = fork();
         if (pid == 0) {
+            sigprocmask(SIG_SETMASK, &waimea->sigmask, NULL);
             dup2(m_pipe[1], STDOUT_FILENO);
             close(m_pipe[0]);
             close(m_pipe[1]);
@@ -725,6 +955,7 @@ WaMenu *WaScreen::CreateDynamicMenu(char *name) {
             exit(127);
         }
         close(m_pipe[1]);
+        if (pid > 0) waimea->AddChild(pid, this);
         rh->linenr = 0;
         delete [] config.menu_file;
         config.menu_file = new char[strlen(*tmp_argv) + 8];
@@ -734,13 +965,12 @@ WaMenu *WaScreen::CreateDynamicMenu(char *name) {
         FILE *fd = fdopen(m_pipe[0], "r");
         dmenu = rh->ParseMenu(dmenu, fd, this);
         fclose(fd);
-        if (waitpid(pid, &status, 0) == -1) {
+        while ((i = waitpid(pid, &status, 0)) == -1 && errno == EINTR);
+        if (i == -1) {
             WARNING;
             perror("waitpid");
-        }
-        action.sa_handler = signalhandler;
-        action.sa_flags = SA_NOCLDSTOP | SA_NODEFER;
-        sigaction(SIGCHLD, &action, NULL);
+        } else
+            waimea->ChildExited(pid);
         if (dmenu != NULL) {
             dmenu->Build(this);
             if (allocname) delete [] allocname;
@@ -752,11 +982,69 @@ WaMenu *WaScreen::CreateDynamicMenu(char *name) {
     return NULL;
 }
 
+/**
+ * @fn    CreateGeneratedMenu(char *name, char **argv)
+ * @brief Creates a generated menu
+ *
+ * Builds menu in-process from a directory listing, installed applications
+ * or the window list. Generated menus are kept in menu list and only
+ * regenerated when a watched directory has changed.
+ *
+ * @param name Name of generated menu to create
+ * @param argv Generator and generator arguments
+ *
+ * @return Created menu, NULL if generator is unknown
+ */
+WaMenu *WaScreen::CreateGeneratedMenu(char *name, char **argv) {
+    GeneratedMenu *gmenu;
+    char *path, *command = NULL;
+    char *__m_wastrdup_tmp;
+    int i, len;
+
+    if (! strcmp(*argv, "@windows")) {
+        window_menu->Build(this);
+        return window_menu;
+    }
+    else if (! strcmp(*argv, "@directory")) {
+        if (! argv[1]) {
+            WARNING << "`" << name << "' missing directory" << endl;
+            return NULL;
+        }
+        path = __m_wastrdup(argv[1]);
+        if (*path == '~' || *path == '$')
+            path = environment_expansion(path);
+        for (i = 2, len = 0; argv[i]; i++) len += strlen(argv[i]) + 1;
+        if (len) {
+            command = new char[len];
+            *command = '\0';
+            for (i = 2; argv[i]; i++) {
+                if (i > 2) strcat(command, " ");
+                strcat(command, argv[i]);
+            }
+        }
+        gmenu = new DirectoryMenu(name, this, path, command);
+        delete [] path;
+        if (command) delete [] command;
+    }
+    else if (! strcmp(*argv, "@applications"))
+        gmenu = new ApplicationMenu(name, this, argv[1]);
+    else {
+        WARNING << "`" << *argv << "' unknown menu generator" << endl;
+        return NULL;
+    }
+    gmenu->Generate();
+    wamenu_list.push_back(gmenu);
+    gmenu->Build(this);
+
+    return gmenu;
+}
+
 /**
  * @fn    CreateFonts(void)
  * @brief Open fonts
  *
- * Opens all fonts and sets frame height.
+ * Opens all fonts and sets frame height. Text rasters of all fonts are
+ * kept in the label cache of this screen.
  */
 void WaScreen::CreateFonts(void) {
     bool set_mih;
@@ -764,6 +1052,13 @@ void WaScreen::CreateFonts(void) {
     if (! mstyle.item_height) set_mih = true;
     else set_mih = false;
 
+#ifdef XFT
+    default_font.label_cache = wstyle.wa_font.label_cache =
+        mstyle.wa_f_font.label_cache = mstyle.wa_b_font.label_cache =
+        mstyle.wa_ct_font.label_cache = mstyle.wa_cf_font.label_cache =
+        mstyle.wa_t_font.label_cache = &label_cache;
+#endif // XFT
+
     if (default_font.Open(display, screen_number, NULL) == -1) {
         ERROR << "failed loading default font" << endl;
         exit(1);
@@ -775,7 +1070,7 @@ void WaScreen::CreateFonts(void) {
 
     int tmp_sx = wstyle.wa_font_u.shodow_off_x;
     int tmp_sy = wstyle.wa_font_u.shodow_off_y;
-    memcpy(&wstyle.wa_font_u, &wstyle.wa_font, sizeof(wstyle.wa_font));
+    wstyle.wa_font_u = wstyle.wa_font;
     wstyle.wa_font_u.shodow_off_x = tmp_sx;
     wstyle.wa_font_u.shodow_off_y = tmp_sy;
 
@@ -784,7 +1079,7 @@ void WaScreen::CreateFonts(void) {
 
     tmp_sx = mstyle.wa_fh_font.shodow_off_x;
     tmp_sy = mstyle.wa_fh_font.shodow_off_y;
-    memcpy(&mstyle.wa_fh_font, &mstyle.wa_f_font, sizeof(mstyle.wa_f_font));
+    mstyle.wa_fh_font = mstyle.wa_f_font;
     mstyle.wa_fh_font.shodow_off_x = tmp_sx;
     mstyle.wa_fh_font.shodow_off_y = tmp_sy;
 
@@ -792,7 +1087,7 @@ void WaScreen::CreateFonts(void) {
     if (set_mih && mstyle.item_height < (unsigned int) (height + 2))
         mstyle.item_height = height + 2;
 
-    memcpy(&mstyle.wa_bh_font, &mstyle.wa_b_font, sizeof(mstyle.wa_b_font));
+    mstyle.wa_bh_font = mstyle.wa_b_font;
     mstyle.wa_bh_font.shodow_off_x = tmp_sx;
     mstyle.wa_bh_font.shodow_off_y = tmp_sy;
 
@@ -800,7 +1095,7 @@ void WaScreen::CreateFonts(void) {
     if (set_mih && mstyle.item_height < (unsigned int) (height + 2))
         mstyle.item_height = height + 2;
 
-    memcpy(&mstyle.wa_cth_font, &mstyle.wa_ct_font, sizeof(mstyle.wa_ct_font));
+    mstyle.wa_cth_font = mstyle.wa_ct_font;
     mstyle.wa_cth_font.shodow_off_x = tmp_sx;
     mstyle.wa_cth_font.shodow_off_y = tmp_sy;
 
@@ -808,7 +1103,7 @@ void WaScreen::CreateFonts(void) {
     if (set_mih && mstyle.item_height < (unsigned int) (height + 2))
         mstyle.item_height = height + 2;
 
-    memcpy(&mstyle.wa_cfh_font, &mstyle.wa_cf_font, sizeof(mstyle.wa_cf_font));
+    mstyle.wa_cfh_font = mstyle.wa_cf_font;
     mstyle.wa_cfh_font.shodow_off_x = tmp_sx;
     mstyle.wa_cfh_font.shodow_off_y = tmp_sy;
 
@@ -846,46 +1141,52 @@ void WaScreen::CreateColors(void) {
     for (; bit != wstyle.buttonstyles.end(); ++bit) {
         if ((*bit)->fg) {
             gcv.foreground = (*bit)->c_focused.getPixel();
-            (*bit)->g_focused = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_focused =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
             gcv.foreground = (*bit)->c_unfocused.getPixel();
-            (*bit)->g_unfocused = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_unfocused =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
             gcv.foreground = (*bit)->c_pressed.getPixel();
-            (*bit)->g_pressed = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_pressed =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
             gcv.foreground = (*bit)->c_focused2.getPixel();
-            (*bit)->g_focused2 = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_focused2 =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
             gcv.foreground = (*bit)->c_unfocused2.getPixel();
-            (*bit)->g_unfocused2 = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_unfocused2 =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
             gcv.foreground = (*bit)->c_pressed2.getPixel();
-            (*bit)->g_pressed2 = XCreateGC(display, id, GCForeground, &gcv);
+            (*bit)->g_pressed2 =
+                XCreateGC(display, gc_pixmap, GCForeground, &gcv);
         }
     }
-    wstyle.wa_font.AllocColor(display, id, &wstyle.l_text_focus,
-                              &wstyle.l_text_focus_s);
-    wstyle.wa_font_u.AllocColor(display, id, &wstyle.l_text_unfocus,
-                                &wstyle.l_text_unfocus_s);
-
-    mstyle.wa_t_font.AllocColor(display, id, &mstyle.t_text,
-                                &mstyle.t_text_s);
-
-    mstyle.wa_f_font.AllocColor(display, id, &mstyle.f_text,
-                                &mstyle.f_text_s);
-    mstyle.wa_fh_font.AllocColor(display, id, &mstyle.f_hilite_text,
-                                 &mstyle.f_hilite_text_s);
-
-    mstyle.wa_b_font.AllocColor(display, id, &mstyle.f_text,
-                                &mstyle.f_text_s);
-    mstyle.wa_bh_font.AllocColor(display, id, &mstyle.f_hilite_text,
-                                 &mstyle.f_hilite_text_s);
-
-    mstyle.wa_ct_font.AllocColor(display, id, &mstyle.f_text,
-                                 &mstyle.f_text_s);
-    mstyle.wa_cth_font.AllocColor(display, id, &mstyle.f_hilite_text,
-                                  &mstyle.f_hilite_text_s);
-
-    mstyle.wa_cf_font.AllocColor(display, id, &mstyle.f_text,
-                                 &mstyle.f_text_s);
-    mstyle.wa_cfh_font.AllocColor(display, id, &mstyle.f_hilite_text,
-                                  &mstyle.f_hilite_text_s);
+    wstyle.wa_font.AllocColor(display, gc_pixmap, &wstyle.l_text_focus,
+                                     &wstyle.l_text_focus_s);
+    wstyle.wa_font_u.AllocColor(display, gc_pixmap, &wstyle.l_text_unfocus,
+                                       &wstyle.l_text_unfocus_s);
+
+    mstyle.wa_t_font.AllocColor(display, gc_pixmap, &mstyle.t_text,
+                                       &mstyle.t_text_s);
+
+    mstyle.wa_f_font.AllocColor(display, gc_pixmap, &mstyle.f_text,
+                                       &mstyle.f_text_s);
+    mstyle.wa_fh_font.AllocColor(display, gc_pixmap, &mstyle.f_hilite_text,
+                                        &mstyle.f_hilite_text_s);
+
+    mstyle.wa_b_font.AllocColor(display, gc_pixmap, &mstyle.f_text,
+                                       &mstyle.f_text_s);
+    mstyle.wa_bh_font.AllocColor(display, gc_pixmap, &mstyle.f_hilite_text,
+                                        &mstyle.f_hilite_text_s);
+
+    mstyle.wa_ct_font.AllocColor(display, gc_pixmap, &mstyle.f_text,
+                                        &mstyle.f_text_s);
+    mstyle.wa_cth_font.AllocColor(display, gc_pixmap, &mstyle.f_hilite_text,
+                                         &mstyle.f_hilite_text_s);
+
+    mstyle.wa_cf_font.AllocColor(display, gc_pixmap, &mstyle.f_text,
+                                        &mstyle.f_text_s);
+    mstyle.wa_cfh_font.AllocColor(display, gc_pixmap, &mstyle.f_hilite_text,
+                                         &mstyle.f_hilite_text_s);
 }
 
 /**
@@ -899,7 +1200,7 @@ void WaScreen::RenderCommonImages(void) {
     list<ButtonStyle *>::iterator bit = wstyle.buttonstyles.begin();
     for (; bit != wstyle.buttonstyles.end(); ++bit) {
         texture = &(*bit)->t_focused;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_focused = None;
             (*bit)->c_focused = texture->getColor()->getPixel();
         } else
@@ -908,7 +1209,7 @@ void WaScreen::RenderCommonImages(void) {
                                                 texture);
 
         texture = &(*bit)->t_unfocused;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_unfocused = None;
             (*bit)->c_unfocused = texture->getColor()->getPixel();
         } else
@@ -917,7 +1218,7 @@ void WaScreen::RenderCommonImages(void) {
                                                   texture);
 
         texture = &(*bit)->t_pressed;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_pressed = None;
             (*bit)->c_pressed = texture->getColor()->getPixel();
         } else
@@ -926,7 +1227,7 @@ void WaScreen::RenderCommonImages(void) {
                                                 texture);
 
         texture = &(*bit)->t_focused2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_focused2 = None;
             (*bit)->c_focused2 = texture->getColor()->getPixel();
         } else
@@ -935,7 +1236,7 @@ void WaScreen::RenderCommonImages(void) {
                                                  texture);
 
         texture = &(*bit)->t_unfocused2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_unfocused2 = None;
             (*bit)->c_unfocused2 = texture->getColor()->getPixel();
         } else
@@ -944,7 +1245,7 @@ void WaScreen::RenderCommonImages(void) {
                                                    texture);
 
         texture = &(*bit)->t_pressed2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             (*bit)->p_pressed2 = None;
             (*bit)->c_pressed2 = texture->getColor()->getPixel();
         } else
@@ -954,14 +1255,14 @@ void WaScreen::RenderCommonImages(void) {
     }
 
     texture = &wstyle.g_focus;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         fgrip = None;
         fgrip_pixel = texture->getColor()->getPixel();
     } else
         fgrip = ic->renderImage(25, wstyle.handle_width, texture);
 
     texture = &wstyle.g_unfocus;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+    if (texture->getTexture() & WaImage_Solid) {
         ugrip = None;
         ugrip_pixel = texture->getColor()->getPixel();
     } else
@@ -984,37 +1285,9 @@ void WaScreen::UpdateWorkarea(void) {
     current_desktop->workarea.x = current_desktop->workarea.y = 0;
     current_desktop->workarea.width = width;
     current_desktop->workarea.height = height;
-
-    list<WMstrut *>::iterator it = strut_list.begin();
-    for (; it != strut_list.end(); ++it) {
-        WindowObject *wo = waimea->FindWin((*it)->window,
-                                           WindowType | DockHandlerType);
-        if (wo) {
-            if (wo->type == WindowType) {
-                if (! (((WaWindow *) wo)->desktop_mask &
-                       (1L << current_desktop->number)))
-                    continue;
-            } else if (wo->type == DockHandlerType) {
-                if (! (((DockappHandler *) wo)->style->desktop_mask &
-                       (1L << current_desktop->number)))
-                    continue;
-            }
-        } else
-            continue;
-
-        if ((*it)->left > current_desktop->workarea.x)
-            current_desktop->workarea.x = (*it)->left;
-        if ((*it)->top > current_desktop->workarea.y)
-            current_desktop->workarea.y = (*it)->top;
-        if ((width - (*it)->right) < current_desktop->workarea.width)
-            current_desktop->workarea.width = width - (*it)->right;
-        if ((height - (*it)->bottom) < current_desktop->workarea.height)
-            current_desktop->workarea.height = height - (*it)->bottom;
-    }
-    current_desktop->workarea.width = current_desktop->workarea.width -
-        current_desktop->workarea.x;
-    current_desktop->workarea.height = current_desktop->workarea.height -
-        current_desktop->workarea.y;
+    StrutArea(&current_desktop->workarea.x, &current_desktop->workarea.y,
+              &current_desktop->workarea.width,
+              &current_desktop->workarea.height);
 
     int res_x, res_y, res_w, res_h;
     if (old_x != current_desktop->workarea.x ||
@@ -1044,6 +1317,57 @@ void WaScreen::UpdateWorkarea(void) {
     }
 }
 
+/**
+ * @fn    StrutArea(int *x, int *y, int *w, int *h)
+ * @brief Shrinks area by struts
+ *
+ * Shrinks area by all struts visible on current desktop. A strut only
+ * affects the area if its start/end range overlaps the area, so struts
+ * of a panel on one xinerama screen don't shrink other xinerama screens.
+ *
+ * @param x Area X value
+ * @param y Area Y value
+ * @param w Area width value
+ * @param h Area height value
+ */
+void WaScreen::StrutArea(int *x, int *y, int *w, int *h) {
+    int x1 = *x, y1 = *y, x2 = *x + *w, y2 = *y + *h;
+
+    list<WMstrut *>::iterator it = strut_list.begin();
+    for (; it != strut_list.end(); ++it) {
+        WMstrut *s = *it;
+        WindowObject *wo = waimea->FindWin(s->window,
+                                           WindowType | DockHandlerType);
+        if (wo) {
+            if (wo->type == WindowType) {
+                if (! (((WaWindow *) wo)->desktop_mask &
+                       (1L << current_desktop->number)))
+                    continue;
+            } else if (wo->type == DockHandlerType) {
+                if (! (((DockappHandler *) wo)->style->desktop_mask &
+                       (1L << current_desktop->number)))
+                    continue;
+            }
+        } else
+            continue;
+
+        if (s->left > x1 && s->left_start < *y + *h && s->left_end >= *y)
+            x1 = s->left;
+        if (width - s->right < x2 && s->right_start < *y + *h &&
+            s->right_end >= *y)
+            x2 = width - s->right;
+        if (s->top > y1 && s->top_start < *x + *w && s->top_end >= *x)
+            y1 = s->top;
+        if (height - s->bottom < y2 && s->bottom_start < *x + *w &&
+            s->bottom_end >= *x)
+            y2 = height - s->bottom;
+    }
+    *x = x1;
+    *y = y1;
+    *w = wamax(x2 - x1, 1);
+    *h = wamax(y2 - y1, 1);
+}
+
 /**
  * @fn    GetWorkareaSize(int *x, int *y, int *w, int *h)
  * @brief Calculates real workarea size
@@ -1077,21 +1401,11 @@ void WaScreen::GetWorkareaSize(int *x, int *y, int *w, int *h) {
                 py > waimea->xinerama_info[i].y_org &&
                 py < (waimea->xinerama_info[i].y_org +
                       waimea->xinerama_info[i].height)) {
-                int diff = waimea->xinerama_info[i].x_org - *x;
-                int xt = waimea->xinerama_info[i].width;
-                if (diff > 0) {
-                    *w -= diff;
-                    *x = waimea->xinerama_info[i].x_org;
-                } else xt += diff;
-                if (*w > xt) *w = xt;
-
-                diff = waimea->xinerama_info[i].y_org - *y;
-                xt = waimea->xinerama_info[i].height;
-                if (diff > 0) {
-                    *h -= diff;
-                    *y = waimea->xinerama_info[i].y_org;
-                } else xt += diff;
-                if (*h > xt) *h = xt;
+                *x = waimea->xinerama_info[i].x_org;
+                *y = waimea->xinerama_info[i].y_org;
+                *w = waimea->xinerama_info[i].width;
+                *h = waimea->xinerama_info[i].height;
+                StrutArea(x, y, w, h);
                 break;
             }
         }
@@ -1632,6 +1946,20 @@ void WaScreen::PointerRelativeWarp(XEvent *, WaAction *ac) {
     XWarpPointer(display, None, None, 0, 0, 0, 0, x, y);
 }
 
+/**
+ * @fn    InstallColormap(Colormap cmap)
+ * @brief Install colormap
+ *
+ * Installs colormap if it isn't the colormap we installed last.
+ *
+ * @param cmap Colormap to install
+ */
+void WaScreen::InstallColormap(Colormap cmap) {
+    if (cmap == installed_colormap) return;
+    XInstallColormap(display, cmap);
+    installed_colormap = cmap;
+}
+
 /**
  * @fn    GoToDesktop(unsigned int number)
  * @brief Go to desktop
@@ -1655,6 +1983,10 @@ void WaScreen::GoToDesktop(unsigned int number) {
         (*dit)->workarea.height = current_desktop->workarea.height;
         current_desktop = (*dit);
 
+#ifdef PIXMAP
+        SetDesktopBackground();
+#endif // PIXMAP
+
         list<WaWindow *>::iterator it = wawindow_list.begin();
         for (; it != wawindow_list.end(); ++it) {
             if ((*it)->desktop_mask & (1L << current_desktop->number)) {
@@ -1698,6 +2030,66 @@ void WaScreen::GoToDesktop(unsigned int number) {
                 number << " doesn't exist" << endl;
 }
 
+#ifdef PIXMAP
+/**
+ * @fn    SetDesktopBackground(void)
+ * @brief Sets root window background for current desktop
+ *
+ * Loads the background image of the current desktop the first time the
+ * desktop is shown and keeps it as a screen sized pixmap, desktops with the
+ * same image share pixmap. The root window background and _XROOTPMAP_ID
+ * are set to the pixmap. As pixmaps are kept, translucent decorations
+ * rendered against a desktops background can be reused when switching back
+ * to it.
+ */
+void WaScreen::SetDesktopBackground(void) {
+    Desktop *d = current_desktop;
+    char *file = config.backgrounds[d->number];
+
+    if (! file) return;
+    if (d->background == None) {
+        list<Desktop *>::iterator it = desktop_list.begin();
+        for (; it != desktop_list.end(); ++it)
+            if ((*it)->background != None &&
+                ! strcmp(config.backgrounds[(*it)->number], file))
+                d->background = (*it)->background;
+    }
+    if (d->background == None) {
+        imlib_context_push(imlib_context);
+        Imlib_Image image = imlib_load_image(file);
+        if (! image) {
+            WARNING << "failed loading image `" << file << "'" << endl;
+            imlib_context_pop();
+            delete [] config.backgrounds[d->number];
+            config.backgrounds[d->number] = NULL;
+            return;
+        }
+        d->background = XCreatePixmap(display, id, width, height,
+                                      DefaultDepth(display, screen_number));
+        XSync(display, false);
+        if (argb_visual) {
+            imlib_context_set_colormap(DefaultColormap(pdisplay,
+                                                       screen_number));
+            imlib_context_set_visual(DefaultVisual(pdisplay, screen_number));
+        }
+        imlib_context_set_image(image);
+        imlib_context_set_drawable(d->background);
+        imlib_render_image_on_drawable_at_size(0, 0, width, height);
+        imlib_free_image();
+        imlib_context_set_drawable(RootWindow(pdisplay, screen_number));
+        if (argb_visual) {
+            imlib_context_set_colormap(colormap);
+            imlib_context_set_visual(ic->getVisual());
+        }
+        imlib_context_pop();
+        XSync(pdisplay, false);
+    }
+    XSetWindowBackgroundPixmap(display, id, d->background);
+    XClearWindow(display, id);
+    net->SetXRootPMapId(this, d->background);
+}
+#endif // PIXMAP
+
 /**
  * @fn    GoToDesktop(XEvent *, WaAction *ac)
  * @brief Go to desktop
@@ -1761,13 +2153,15 @@ void WaScreen::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
     list<WaAction *>::iterator it = acts->begin();
     for (; it != acts->end(); ++it) {
         if (eventmatch(*it, ed)) {
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+            if ((*it)->seq)
+                waimea->eh->StartKeySequence((*it)->seq, e, id);
+            else if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
                 Interrupt *i = new Interrupt(*it, e, id);
                 waimea->timer->AddInterrupt(i);
             }
             else {
                 if ((*it)->exec)
-                    waexec((*it)->exec, displaystring);
+                    waexec((*it)->exec, this);
                 else
                     ((*this).*((*it)->rootfunc))(e, *it);
             }
@@ -1867,6 +2261,7 @@ void WaScreen::RRUpdate(void) {
     XMoveResizeWindow(display, east->id, width - 2, 0, 2, height);
     XMoveResizeWindow(display, north->id, 0, 0, width, 2);
     XMoveResizeWindow(display, south->id, 0, height - 2, width, 2);
+    outline->Resize();
 
     list<DockappHandler *>::iterator dit = docks.begin();
     for (; dit != docks.end(); ++dit)
@@ -1878,6 +2273,67 @@ void WaScreen::RRUpdate(void) {
 }
 #endif // RANDR
 
+/**
+ * @fn    matchregex(char *s, int *type)
+ * @brief Creates window match regular expression
+ *
+ * Creates regular expression from window match string `s'. If `s' starts
+ * with "c/" matching is done with window class, if `s' starts with "n/"
+ * matching is done with class name and if `s' starts with "t/" matching is
+ * done with window title name.
+ *
+ * @param s Window match string
+ * @param type Returns type of match
+ *
+ * @return Regular expression, NULL if `s' isn't a valid match string
+ */
+static Regex *matchregex(char *s, int *type) {
+    if (! s) return NULL;
+
+    int len = strlen(s);
+    if (len < 4) return NULL;
+
+    if (*s == 't') *type = 1;
+    else if (*s == 'c') *type = 2;
+    else if (*s == 'n') *type = 3;
+    else return NULL;
+
+    s[len - 1] = '\0';
+    Regex *r = new Regex(s + 2);
+    s[len - 1] = '/';
+
+    return r;
+}
+
+/**
+ * @fn    matchwindow(WaWindow *ww, int type, Regex *r)
+ * @brief Match window with regular expression
+ *
+ * @param ww Window to match
+ * @param type Type of match returned from matchregex
+ * @param r Regular expression returned from matchregex
+ *
+ * @return True if window matches
+ */
+static bool matchwindow(WaWindow *ww, int type, Regex *r) {
+    switch (type) {
+        case 1: {
+            char tmp = ww->name[ww->realnamelen];
+            ww->name[ww->realnamelen] = '\0';
+            bool match = r->Match(ww->name);
+            ww->name[ww->realnamelen] = tmp;
+            return match;
+        }
+        case 2:
+            return (ww->classhint && ww->classhint->res_class &&
+                    r->Match(ww->classhint->res_class));
+        case 3:
+            return (ww->classhint && ww->classhint->res_name &&
+                    r->Match(ww->classhint->res_name));
+    }
+    return false;
+}
+
 /**
  * @fn    RegexMatchWindow(char *s, WaWindow *ign)
  * @brief Find window matching regular expression
@@ -1894,53 +2350,141 @@ void WaScreen::RRUpdate(void) {
  */
 WaWindow *WaScreen::RegexMatchWindow(char *s, WaWindow *ign) {
     int type = 0;
-    if (! s) return NULL;
-
-    int len = strlen(s);
-    if (len < 4) return NULL;
-
-    if (*s == 't') type = 1;
-    else if (*s == 'c') type = 2;
-    else if (*s == 'n') type = 3;
-    else return NULL;
-
-    s[len - 1] = '\0';
-    Regex *r = new Regex(s + 2);
-    s[len - 1] = '/';
+    Regex *r = matchregex(s, &type);
+    if (! r) return NULL;
 
     list<WaWindow *>::iterator it = wawindow_list.begin();
     for (; it != wawindow_list.end(); it++) {
         if (*it == ign) continue;
-        switch (type) {
-            case 1: {
-                char tmp = (*it)->name[(*it)->realnamelen];
-                (*it)->name[(*it)->realnamelen] = '\0';
-                if (r->Match((*it)->name)) {
-                    (*it)->name[(*it)->realnamelen] = tmp;
-                    delete r;
-                    return *it;
-                }
-                (*it)->name[(*it)->realnamelen] = tmp;
-            } break;
-            case 2:
-                if ((*it)->classhint && (*it)->classhint->res_class)
-                    if (r->Match((*it)->classhint->res_class)) {
-                        delete r;
-                        return *it;
-                    }
-                break;
-            case 3:
-                if ((*it)->classhint && (*it)->classhint->res_name)
-                    if (r->Match((*it)->classhint->res_name)) {
-                        delete r;
-                        return *it;
-                    }
+        if (matchwindow(*it, type, r)) {
+            delete r;
+            return *it;
         }
     }
     delete r;
     return NULL;
 }
 
+/**
+ * @fn    RegexMatchWindows(char *s, list<WaWindow *> *matches)
+ * @brief Find all windows matching regular expression
+ *
+ * Same as RegexMatchWindow but adds all matching windows to list.
+ *
+ * @param s String to create regular expression from
+ * @param matches List to add matching windows to
+ */
+void WaScreen::RegexMatchWindows(char *s, list<WaWindow *> *matches) {
+    int type = 0;
+    Regex *r = matchregex(s, &type);
+    if (! r) return;
+
+    list<WaWindow *>::iterator it = wawindow_list.begin();
+    for (; it != wawindow_list.end(); it++)
+        if (matchwindow(*it, type, r))
+            matches->push_back(*it);
+    delete r;
+}
+
+/**
+ * @fn    DesktopMatch(char *param, int op)
+ * @brief Change desktop membership of matching windows
+ *
+ * Parameter is a window match string followed by a whitespace separated
+ * list of desktop numbers, or `all'. All windows matching are joined to
+ * (JoinDesktopOp), parted from (PartDesktopOp) or set to be member of
+ * only (DesktopMaskOp) the listed desktops. Frames are mapped and unmapped
+ * first and then all desktop hints are written in one batch.
+ *
+ * @param param Action parameter
+ * @param op Operation to perform on desktop masks
+ */
+void WaScreen::DesktopMatch(char *param, int op) {
+    char *end, *spec;
+    long int mask = 0, new_mask;
+
+    if (! param || ! (end = strrchr(param, '/'))) return;
+
+    for (spec = end + 1; *spec;) {
+        if (isdigit(*spec)) {
+            unsigned int desk = (unsigned int) strtoul(spec, &spec, 10);
+            if (desk < config.desktops) mask |= (1L << desk);
+        }
+        else if (! strncasecmp("all", spec, 3)) {
+            mask = (1L << 16) - 1;
+            spec += 3;
+        }
+        else spec++;
+    }
+    if (! mask) return;
+
+    list<WaWindow *> matches, changed;
+    char tmp = end[1];
+    end[1] = '\0';
+    RegexMatchWindows(param, &matches);
+    end[1] = tmp;
+
+    WaWindow *focused = NULL;
+    list<WaWindow *>::iterator it = matches.begin();
+    for (; it != matches.end(); ++it) {
+        WaWindow *ww = ((*it)->master)? (*it)->master: *it;
+        switch (op) {
+            case JoinDesktopOp: new_mask = ww->desktop_mask | mask; break;
+            case PartDesktopOp: new_mask = ww->desktop_mask & ~mask; break;
+            default: new_mask = mask;
+        }
+        if (! new_mask || new_mask == ww->desktop_mask) continue;
+
+        ww->desktop_mask = new_mask;
+        list<WaWindow *>::iterator mit = ww->merged.begin();
+        for (; mit != ww->merged.end(); ++mit) {
+            (*mit)->desktop_mask = new_mask;
+            changed.push_back(*mit);
+        }
+        changed.push_back(ww);
+
+        if (new_mask & (1L << current_desktop->number))
+            ww->Show();
+        else if (ww->has_focus)
+            focused = ww;
+        else
+            ww->Hide();
+    }
+    if (focused) focused->Hide();
+
+    if (! changed.empty()) net->SetDesktops(&changed);
+}
+
+/**
+ * @fn    JoinDesktopMatch(XEvent *, WaAction *ac)
+ * @brief Join matching windows to desktops
+ *
+ * @param ac WaAction object
+ */
+void WaScreen::JoinDesktopMatch(XEvent *, WaAction *ac) {
+    DesktopMatch(ac->param, JoinDesktopOp);
+}
+
+/**
+ * @fn    PartDesktopMatch(XEvent *, WaAction *ac)
+ * @brief Part matching windows from desktops
+ *
+ * @param ac WaAction object
+ */
+void WaScreen::PartDesktopMatch(XEvent *, WaAction *ac) {
+    DesktopMatch(ac->param, PartDesktopOp);
+}
+
+/**
+ * @fn    DesktopMaskMatch(XEvent *, WaAction *ac)
+ * @brief Set desktop mask of matching windows
+ *
+ * @param ac WaAction object
+ */
+void WaScreen::DesktopMaskMatch(XEvent *, WaAction *ac) {
+    DesktopMatch(ac->param, DesktopMaskOp);
+}
+
 /**
  * @fn    SmartName(WaWindow *ww)
  * @brief Sets viewable title name for a window
@@ -1964,8 +2508,7 @@ void WaScreen::SmartName(WaWindow *ww) {
             char *newn = new char[(*it)->realnamelen + 6];
             (*it)->name[(*it)->realnamelen] = '\0';
             sprintf(newn, "%s <%d>", (*it)->name, match + 1);
-            delete [] (*it)->name;
-            (*it)->name = newn;
+            (*it)->SetName(newn);
             if (config.db) {
                 (*it)->title->Render();
                 (*it)->label->Render();
@@ -1979,8 +2522,7 @@ void WaScreen::SmartName(WaWindow *ww) {
     if (match) {
         char *newn = new char[ww->realnamelen + 6];
         sprintf(newn, "%s <%d>", ww->name, match + 1);
-        delete [] ww->name;
-        ww->name = newn;
+        ww->SetName(newn);
     }
 }
 
@@ -2010,8 +2552,7 @@ void WaScreen::SmartNameRemove(WaWindow *ww) {
                 char *newn = new char[(*it)->realnamelen + 6];
                 (*it)->name[(*it)->realnamelen] = '\0';
                 sprintf(newn, "%s <%d>", (*it)->name, match + 1);
-                delete [] (*it)->name;
-                (*it)->name = newn;
+                (*it)->SetName(newn);
                 if (config.db) {
                     (*it)->title->Render();
                     (*it)->label->Render();
@@ -2031,8 +2572,7 @@ void WaScreen::SmartNameRemove(WaWindow *ww) {
             sprintf(newn, "%s <%d>", fw->name, 1);
         else
             sprintf(newn, "%s", fw->name);
-        delete [] fw->name;
-        fw->name = newn;
+        fw->SetName(newn);
         if (config.db) {
             fw->title->Render();
             fw->label->Render();
@@ -33,6 +33,8 @@ extern "C" {
 
 class WaScreen;
 class ScreenEdge;
+class WaIcon;
+class WaOutline;
 
 typedef struct _WaAction WaAction;
 typedef void (WaScreen::*RootActionFn)(XEvent *, WaAction *);
@@ -43,6 +45,10 @@ typedef struct {
     int right;
     int top;
     int bottom;
+    int left_start, left_end;
+    int right_start, right_end;
+    int top_start, top_end;
+    int bottom_start, bottom_end;
 } WMstrut;
 
 #include "Image.hh"
@@ -66,9 +72,19 @@ public:
         workarea.x = workarea.y = 0;
         workarea.width = w;
         workarea.height = h;
+
+#ifdef PIXMAP
+        background = None;
+#endif // PIXMAP
+
     }
     unsigned int number;
     Workarea workarea;
+
+#ifdef PIXMAP
+    Pixmap background;
+#endif // PIXMAP
+
 };
 
 class SystrayWindow : public WindowObject {
@@ -95,6 +111,10 @@ public:
 #define NorthDirection 3
 #define SouthDirection 4
 
+#define JoinDesktopOp 1
+#define PartDesktopOp 2
+#define DesktopMaskOp 3
+
 typedef struct {
     WaColor l_text_focus, l_text_focus_s, l_text_unfocus, l_text_unfocus_s,
         border_color, outline_color;
@@ -123,11 +143,11 @@ typedef struct {
 } MenuStyle;
 
 typedef struct {
-    char *style_file, *menu_file, *action_file;
+    char *style_file, *menu_file, *action_file, *rules_file;
     unsigned int virtual_x;
     unsigned int virtual_y;
     unsigned int desktops;
-    int colors_per_channel, menu_stacking;
+    int colors_per_channel, menu_stacking, snap_distance, edge_resistance;
     long unsigned int cache_max;
     bool image_dither, transient_above, db, revert_to_window;
 
@@ -135,14 +155,21 @@ typedef struct {
     bool lazy_trans;
 #endif // RENDER
 
+#ifdef PIXMAP
+    char *backgrounds[16];
+#endif // PIXMAP
+
     list<WaAction *> frameacts, awinacts, pwinacts, titleacts, labelacts,
         handleacts, rgacts, lgacts, rootacts, weacts, eeacts, neacts,
         seacts, mtacts, miacts, msacts, mcbacts;
     list<WaAction *> **bacts;
+    list<WaAction *> keyacts;
 
     list<WaActionExtList *> ext_frameacts, ext_awinacts, ext_pwinacts,
         ext_titleacts, ext_labelacts, ext_handleacts, ext_rgacts, ext_lgacts;
     list<WaActionExtList *> **ext_bacts;
+
+    list<WaWindowRule *> rules;
 } ScreenConfig;
 
 class WaScreen : public WindowObject {
@@ -150,12 +177,17 @@ public:
     WaScreen(Display *, int, Waimea *);
     virtual ~WaScreen(void);
 
-    void RaiseWindow(Window);
-    void LowerWindow(Window);
+    void RaiseWindow(Window, bool = true);
+    void LowerWindow(Window, bool = true);
     void RestackWindows(Window);
+    void RaiseGroup(Window);
+    void LowerGroup(Window);
+    void GroupMembers(Window, list<WaWindow *> *);
     void UpdateCheckboxes(int);
+    void UpdateIcons(Window);
     WaMenu *GetMenuNamed(char *);
     WaMenu *CreateDynamicMenu(char *);
+    WaMenu *CreateGeneratedMenu(char *, char **);
     void MoveViewportTo(int, int);
     void MoveViewport(int);
     void ScrollViewport(int, bool, WaAction *);
@@ -163,10 +195,19 @@ public:
     void MenuRemap(XEvent *, WaAction *, bool);
     void MenuUnmap(XEvent *, WaAction *, bool);
     void UpdateWorkarea(void);
+    void StrutArea(int *, int *, int *, int *);
     void GetWorkareaSize(int *, int *, int *, int *);
     void AddDockapp(Window window);
     void GoToDesktop(unsigned int);
+
+#ifdef PIXMAP
+    void SetDesktopBackground(void);
+#endif // PIXMAP
+
+    void InstallColormap(Colormap);
     WaWindow *RegexMatchWindow(char *, WaWindow * = NULL);
+    void RegexMatchWindows(char *, list<WaWindow *> *);
+    void DesktopMatch(char *, int);
     void SmartName(WaWindow *);
     void SmartNameRemove(WaWindow *);
 
@@ -207,6 +248,9 @@ public:
     void GoToDesktop(XEvent *, WaAction *);
     void NextDesktop(XEvent *, WaAction *);
     void PreviousDesktop(XEvent *, WaAction *);
+    void JoinDesktopMatch(XEvent *, WaAction *);
+    void PartDesktopMatch(XEvent *, WaAction *);
+    void DesktopMaskMatch(XEvent *, WaAction *);
 
     inline void MoveViewportLeft(XEvent *, WaAction *) {
         MoveViewport(WestDirection);
@@ -241,6 +285,10 @@ public:
 
     Pixmap fgrip, ugrip;
     Display *pdisplay;
+    bool argb_visual;
+    unsigned long alpha_mask;
+    Pixmap gc_pixmap;
+    GC copy_gc;
 
 #ifdef RENDER
     bool render_extension;
@@ -251,6 +299,10 @@ public:
     Imlib_Context imlib_context;
 #endif // PIXMAP
 
+#ifdef XFT
+    LabelCache label_cache;
+#endif // XFT
+
     unsigned long fbutton_pixel, ubutton_pixel, pbutton_pixel, fgrip_pixel,
         ugrip_pixel;
     char displaystring[1024];
@@ -268,6 +320,10 @@ public:
     list<WMstrut *> strut_list;
     list<DockappHandler *> docks;
     list<Window> systray_window_list;
+    map<unsigned long, WaIcon *> icons;
+    map<Window, list<WaWindow *> > groups;
+    WaOutline *outline;
+    Colormap installed_colormap;
 
     list<MReq *> mreqs;
 
@@ -275,6 +331,11 @@ private:
     void CreateVerticalEdges(void);
     void CreateHorizontalEdges(void);
     void CreateColors(void);
+
+#ifdef RENDER
+    void SetARGBVisual(void);
+#endif // RENDER
+
     void CreateFonts(void);
     void RenderCommonImages(void);
 
@@ -242,44 +242,7 @@ void timeout(int signal) {
         }
     }
 
-    map<Window, WindowObject *>::iterator wit;
-    if ((wit = timer->waimea->window_table.find(i->id)) !=
-        timer->waimea->window_table.end()) {
-        WindowObject *wo = (*wit).second;
-
-        switch (wo->type) {
-            case WindowType: {
-                WaWindow *wa = (WaWindow *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, wa->wascreen->displaystring);
-                else {
-                    ((*wa).*(i->action->winfunc))(&i->event, i->action);
-                    XSync(wa->display, false);
-                }
-            } break;
-            case MenuTitleType:
-            case MenuItemType:
-            case MenuCBItemType:
-            case MenuSubType: {
-                WaMenuItem *wm = (WaMenuItem *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, wm->menu->wascreen->displaystring);
-                else {
-                    ((*wm).*(i->action->menufunc))(&i->event, i->action);
-                    XSync(wm->menu->display, false);
-                }
-            } break;
-            case RootType: {
-                WaScreen *ws = (WaScreen *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, ws->displaystring);
-                else {
-                    ((*ws).*(i->action->rootfunc))(&i->event, i->action);
-                    XSync(ws->display, false);
-                }
-            } break;
-        }
-    }
+    timer->waimea->eh->ExecAction(i->action, &i->event, i->id);
     delete i;
     timer->Start();
 }
@@ -18,6 +18,7 @@
 extern "C" {
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <X11/Xproto.h>
 
 #ifdef    SHAPE
 #  include <X11/extensions/shape.h>
@@ -52,6 +53,10 @@ extern "C" {
 #ifdef    HAVE_STRING_H
 #  include <string.h>
 #endif // HAVE_STRING_H
+
+#ifdef    HAVE_SYS_INOTIFY_H
+#  include <sys/inotify.h>
+#endif // HAVE_SYS_INOTIFY_H
 }
 
 #include <iostream>
@@ -65,6 +70,7 @@ Waimea *waimea;
 char **argv;
 bool hush;
 int errors;
+static volatile sig_atomic_t child_signal;
 
 /**
  * @fn    Waimea(char **av)
@@ -94,18 +100,26 @@ Waimea::Waimea(char **av, struct waoptions *_options) {
     waimea = this;
     hush = wmerr = false;
     errors = 0;
+    child_signal = 0;
     eh = NULL;
     timer = NULL;
 
     action.sa_handler = signalhandler;
     action.sa_mask = sigset_t();
-    action.sa_flags = SA_NOCLDSTOP | SA_NODEFER;
+    action.sa_flags = SA_NOCLDSTOP | SA_NODEFER | SA_RESTART;
 
     sigaction(SIGTERM, &action, NULL);
     sigaction(SIGINT, &action, NULL);
     sigaction(SIGCHLD, &action, NULL);
     sigaction(SIGHUP, &action, NULL);
 
+    // SIGCHLD is only delivered while the event loop waits in pselect()
+    sigset_t chld_mask;
+    sigemptyset(&chld_mask);
+    sigaddset(&chld_mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld_mask, &sigmask);
+    sigdelset(&sigmask, SIGCHLD);
+
     session_cursor = XCreateFontCursor(display, XC_left_ptr);
     move_cursor = XCreateFontCursor(display, XC_fleur);
     resizeleft_cursor = XCreateFontCursor(display, XC_ll_angle);
@@ -131,6 +145,12 @@ Waimea::Waimea(char **av, struct waoptions *_options) {
     randr = XRRQueryExtension(display, &randr_event, &dummy);
 #endif // RANDR
 
+#ifdef HAVE_SYS_INOTIFY_H
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else // ! HAVE_SYS_INOTIFY_H
+    inotify_fd = -1;
+#endif // HAVE_SYS_INOTIFY_H
+
     rh = new ResourceHandler(this, options);
     net = new NetHandler(this);
 
@@ -163,21 +183,25 @@ Waimea::Waimea(char **av, struct waoptions *_options) {
  * @fn    ~Waimea(void)
  * @brief Destructor for Waimea class
  *
- * Deletes all WaScreens. Closes the connection to the display.
+ * Deletes all WaScreens and child process records. Closes the connection
+ * to the display and restores the signal mask.
  */
 Waimea::~Waimea(void) {
     XSetErrorHandler(NULL);
     LISTDEL(wascreen_list);
+    if (inotify_fd >= 0) close(inotify_fd);
     delete net;
     delete rh;
     MAPCLEAR(window_table);
     if (eh) delete eh;
     if (timer) delete timer;
+    LISTDEL(children);
 
     delete [] pathenv;
 
     XSync(display, false);
     XCloseDisplay(display);
+    sigprocmask(SIG_SETMASK, &sigmask, NULL);
 }
 
 /**
@@ -200,6 +224,136 @@ WindowObject *Waimea::FindWin(Window id, int mask) {
     return NULL;
 }
 
+/**
+ * @fn    AddChild(int pid, WaScreen *ws)
+ * @brief Records child process
+ *
+ * Adds a child process to the list of supervised children. Desktop that is
+ * current on the launching screen is remembered so that windows mapped by
+ * the child can be placed on it.
+ *
+ * @param pid Process ID of child
+ * @param ws WaScreen the child was launched from
+ */
+void Waimea::AddChild(int pid, WaScreen *ws) {
+    ChildProcess *c = new ChildProcess;
+
+    c->pid = pid;
+    c->running = true;
+    c->ws = ws;
+    c->desktop = (ws && ws->current_desktop)?
+        (int) ws->current_desktop->number: -1;
+    gettimeofday(&c->started, NULL);
+    children.push_back(c);
+}
+
+/**
+ * @fn    ChildExited(int pid)
+ * @brief Records child exit
+ *
+ * Marks a reaped child process as exited. Records of exited children are
+ * kept until there are more than ChildHistoryMax records, then the oldest
+ * records are removed. Processes the child started may still map windows
+ * after the child itself has exited.
+ *
+ * @param pid Process ID of child
+ */
+void Waimea::ChildExited(int pid) {
+    list<ChildProcess *>::reverse_iterator rit = children.rbegin();
+    for (; rit != children.rend(); ++rit) {
+        if ((*rit)->pid == pid && (*rit)->running) {
+            (*rit)->running = false;
+            break;
+        }
+    }
+
+    list<ChildProcess *>::iterator it = children.begin();
+    while (children.size() > ChildHistoryMax && it != children.end()) {
+        if (! (*it)->running) {
+            delete *it;
+            it = children.erase(it);
+        } else ++it;
+    }
+}
+
+/**
+ * @fn    ReapChildren(void)
+ * @brief Reaps exited children
+ *
+ * Collects all child processes that have exited since the last SIGCHLD.
+ * Signals are coalesced so waitpid is called until no more children are
+ * waiting. Called from the event loop, not from signal context.
+ */
+void Waimea::ReapChildren(void) {
+    int pid;
+
+    if (! child_signal) return;
+    child_signal = 0;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0)
+        ChildExited(pid);
+}
+
+/**
+ * @fn    AdoptChildWindow(WaWindow *ww)
+ * @brief Associates window with child process
+ *
+ * Looks up the child process matching the _NET_WM_PID hint of a newly
+ * adopted window. Children are started in a new session by a shell, so
+ * the window may belong to any process in the session of the child, the
+ * session ID is matched as well. Windows mapped within ChildLaunchTimeout
+ * seconds from launch are put on the desktop the child was launched from.
+ *
+ * @param ww WaWindow object
+ */
+void Waimea::AdoptChildWindow(WaWindow *ww) {
+    struct timeval now;
+
+    if (! ww->pid) return;
+    int pid = atoi(ww->pid);
+    if (pid <= 0) return;
+    int sid = getsid(pid);
+
+    list<ChildProcess *>::reverse_iterator rit = children.rbegin();
+    for (; rit != children.rend(); ++rit) {
+        if ((*rit)->pid != pid && (*rit)->pid != sid) continue;
+        ChildProcess *c = *rit;
+        gettimeofday(&now, NULL);
+        if (c->ws == ww->wascreen && c->desktop >= 0 &&
+            (unsigned int) c->desktop < ww->wascreen->config.desktops &&
+            now.tv_sec - c->started.tv_sec < ChildLaunchTimeout)
+            ww->desktop_mask = (1L << c->desktop);
+        break;
+    }
+}
+
+/**
+ * @fn    ReadInotify(void)
+ * @brief Reads pending inotify events
+ *
+ * Marks generated menus watching a directory that changed as stale. A
+ * queue overflow marks all generated menus as stale. Watches removed by
+ * inotify (IN_IGNORED) are dropped by the menus holding them, as their
+ * descriptors may be reused. Called before a generated menu is mapped, so
+ * no events are read while menus are closed.
+ */
+void Waimea::ReadInotify(void) {
+#ifdef HAVE_SYS_INOTIFY_H
+    long buf[1024];
+    int len, i;
+
+    if (inotify_fd < 0) return;
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (i = 0; i < len;) {
+            struct inotify_event *ev =
+                (struct inotify_event *) ((char *) buf + i);
+            list<GeneratedMenu *>::iterator it = generated_menus.begin();
+            for (; it != generated_menus.end(); ++it)
+                (*it)->Invalidate(ev->wd, ev->mask & IN_IGNORED);
+            i += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+#endif // HAVE_SYS_INOTIFY_H
+}
 
 /**
  * @fn    validatedrawable(Drawable d, unsigned int *w, unsigned int *h)
@@ -263,28 +417,37 @@ const bool validateclient_mapped(Window id) {
 
 
 /**
- * @fn    waexec(const char *command, char *displaystring)
+ * @fn    waexec(const char *command, WaScreen *ws)
  * @brief Executes a command line
  *
- * Executes a command line in the 'sh' shell.
+ * Executes a command line in the 'sh' shell. The child process is
+ * recorded so that it can be reaped and associated with its windows.
+ *
+ * @param command Command line to execute
+ * @param ws WaScreen to execute command on
  *
- * @param format Command line to execute
- * @param displaystring Displaystring to export prior to execution
+ * @return Process ID of child, -1 if fork failed
  */
-void waexec(const char *command, char *displaystring) {
-    if (! fork()) {
+int waexec(const char *command, WaScreen *ws) {
+    int pid = fork();
+    if (! pid) {
+        sigprocmask(SIG_SETMASK, &waimea->sigmask, NULL);
         setsid();
-        putenv(displaystring);
+        putenv(ws->displaystring);
         execl("/bin/sh", "/bin/sh", "-c", command, NULL);
         exit(0);
     }
+    if (pid > 0) waimea->AddChild(pid, ws);
+    return pid;
 }
 
 /**
  * @fn    xerrorhandler(Display *d, XErrorEvent *e)
  * @brief X error handler function
  *
- * Prints error message then a X error occurs.
+ * Prints error message then a X error occurs. Errors from focus requests
+ * and client messages to windows that have been destroyed are expected
+ * as these are done without server grabs, they are silently ignored.
  *
  * @param d X display
  * @param e X error event
@@ -297,6 +460,11 @@ int xerrorhandler(Display *d, XErrorEvent *e) {
 
     errors++;
 
+    if ((e->request_code == X_SetInputFocus ||
+         e->request_code == X_SendEvent) &&
+        (e->error_code == BadWindow || e->error_code == BadMatch))
+        return 0;
+
     if (! hush) {
         XGetErrorDatabaseText(d, "XlibMessage", "XError", "", buff, 128);
         cerr << buff;
@@ -346,12 +514,11 @@ int wmrunningerror(Display *d, XErrorEvent *) {
  *
  * When one of the signals we handle arrives this function is called. Depending
  * on what type of signal we received we do something, ex. restart, exit.
+ * Exited children are only flagged here and reaped by the event loop.
  *
  * @param sig The signal we received
  */
 void signalhandler(int sig) {
-    int status;
-
     switch(sig) {
         case SIGINT:
         case SIGTERM:
@@ -361,7 +528,7 @@ void signalhandler(int sig) {
             restart(NULL);
             break;
         case SIGCHLD:
-            waitpid(-1, &status, WNOHANG | WUNTRACED);
+            child_signal = 1;
             break;
         default:
             quit(EXIT_FAILURE);
@@ -17,6 +17,10 @@
 extern "C" {
 #include <X11/Xlib.h>
 #include <X11/cursorfont.h>
+
+#ifdef    HAVE_SIGNAL_H
+#  include <signal.h>
+#endif // HAVE_SIGNAL_H
 }
 
 #include <list>
@@ -29,6 +33,7 @@ using std::make_pair;
 typedef struct _WaAction WaAction;
 
 class Waimea;
+class GeneratedMenu;
 
 #define __m_wastrdup(_str) (((__m_wastrdup_tmp = \
                               new char[strlen(_str) + 1]) && \
@@ -154,12 +159,27 @@ enum {
 #include "Timer.hh"
 #include "Net.hh"
 
+#define ChildHistoryMax    64
+#define ChildLaunchTimeout 15
+
+typedef struct {
+    int pid, desktop;
+    bool running;
+    WaScreen *ws;
+    struct timeval started;
+} ChildProcess;
+
 class Waimea {
 public:
     Waimea(char **, struct waoptions *);
     virtual ~Waimea(void);
 
     WindowObject *FindWin(Window, int);
+    void AddChild(int, WaScreen *);
+    void ChildExited(int);
+    void ReapChildren(void);
+    void AdoptChildWindow(WaWindow *);
+    void ReadInotify(void);
 
     struct waoptions *options;
     Display *display;
@@ -168,12 +188,18 @@ public:
     NetHandler *net;
     Timer *timer;
     Cursor session_cursor, move_cursor, resizeleft_cursor, resizeright_cursor;
-    unsigned long double_click, screenmask;
+    unsigned long double_click, hold_time, key_sequence_timeout, screenmask;
+    unsigned long request_rate;
+    int drag_threshold;
     char *pathenv;
     bool wmerr;
+    sigset_t sigmask;
 
     map<Window, WindowObject *> window_table;
     list<WaScreen *> wascreen_list;
+    list<ChildProcess *> children;
+    list<GeneratedMenu *> generated_menus;
+    int inotify_fd;
 
 #ifdef SHAPE
     int shape, shape_event;
@@ -195,7 +221,7 @@ bool validatedrawable(Drawable, unsigned int * = NULL, unsigned int * = NULL);
 const bool validateclient_mapped(Window);
 void wawarning(char *, ...);
 void waerror(char *, ...);
-void waexec(const char *, char *);
+int waexec(const char *, WaScreen *);
 int xerrorhandler(Display *, XErrorEvent *);
 int wmrunningerror(Display *, XErrorEvent *);
 void signalhandler(int);
@@ -27,7 +27,11 @@ extern "C" {
 #endif // STDC_HEADERS
 }
 
+#include <algorithm>
+
 #include "Window.hh"
+#include "Icon.hh"
+#include "Outline.hh"
 
 /**
  * @fn    WaWindow(Window win_id, WaScreen *scrn) :
@@ -52,9 +56,11 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     ic = wascreen->ic;
     net = waimea->net;
     wm_strut = NULL;
+    icon = NULL;
     move_resize = false;
     classhint = NULL;
     name = __m_wastrdup("");
+    name_text.Set(name);
     realnamelen = 0;
     master = NULL;
 
@@ -72,7 +78,10 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     attrib.height = init_attrib.height;
     pos_init = attrib.x && attrib.y;
 
-    want_focus = mapped = dontsend = deleted = ign_config_req = hidden = false;
+    want_focus = mapped = dontsend = deleted = ign_config_req = hidden =
+        client_unmapped = take_focus = false;
+    input_hint = true;
+    ign_unmap = 0;
 
     desktop_mask = (1L << wascreen->current_desktop->number);
 
@@ -85,6 +94,11 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
 #endif // RENDER
 
     border_w = title_w = handle_w = 0;
+    frame_extents[0] = frame_extents[1] = frame_extents[2] =
+        frame_extents[3] = -1;
+    req_tokens = waimea->request_rate;
+    req_throttled = false;
+    monotonic_time(&req_time);
     has_focus = mergedback = false;
     flags.sticky = flags.shaded = flags.max = flags.title = flags.handle =
         flags.border = flags.all = flags.alwaysontop =
@@ -98,6 +112,7 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     net->GetMWMHints(this);
     net->GetWMNormalHints(this);
     net->GetWmPid(this);
+    net->GetWmIcon(this);
 
     Gravitate(ApplyGravity);
     InitPosition();
@@ -144,6 +159,7 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     net->GetWmType(this);
     net->GetVirtualPos(this);
     net->GetWmStrut(this);
+    waimea->AdoptChildWindow(this);
     net->GetDesktop(this);
     net->SetDesktop(this);
     net->SetDesktopMask(this);
@@ -151,6 +167,7 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     ReparentWin();
     if (! net->GetNetName(this)) net->GetXaName(this);
     if (*name == '\0') SetActionLists();
+    WaWindowRule *merge_rule = ApplyRules();
     UpdateGrabs();
 
     if (deleted) { delete this; return; }
@@ -166,13 +183,19 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     waimea->window_table.insert(make_pair(id, this));
     wascreen->wawindow_list.push_back(this);
     wascreen->wawindow_list_map_order.push_back(this);
+    if (group) wascreen->groups[group].push_back(this);
     if (! flags.alwaysontop && ! flags.alwaysatbottom)
         wascreen->stacking_list.push_back(frame->id);
 
-    if (deleted) delete this;
+    if (deleted) { delete this; return; }
     wascreen->RaiseWindow(frame->id);
     net->SetAllowedActions(this);
     net->SetWmState(this);
+
+    if (merge_rule) {
+        WaWindow *mw = wascreen->RegexMatchWindow(merge_rule->merge, this);
+        if (mw) mw->Merge(this, merge_rule->mergetype);
+    }
 }
 
 /**
@@ -185,6 +208,15 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
 WaWindow::~WaWindow(void) {
     waimea->window_table.erase(id);
 
+    if (group) {
+        map<Window, list<WaWindow *> >::iterator git =
+            wascreen->groups.find(group);
+        if (git != wascreen->groups.end()) {
+            git->second.remove(this);
+            if (git->second.empty()) wascreen->groups.erase(git);
+        }
+    }
+
     if (transient_for) {
         if (transient_for == wascreen->id) {
             list<WaWindow *>::iterator it =
@@ -205,6 +237,21 @@ WaWindow::~WaWindow(void) {
     Explode(NULL, NULL);
     if (master) master->Unmerge(this);
 
+    if (ign_unmap || client_unmapped) {
+        XEvent e;
+        XSync(display, false);
+        while (ign_unmap &&
+               XCheckTypedWindowEvent(display, id, UnmapNotify, &e)) {
+            if (e.xunmap.send_event) {
+                XPutBackEvent(display, &e);
+                break;
+            }
+            ign_unmap--;
+        }
+        if (client_unmapped && wascreen->shutdown && ! deleted)
+            XMapWindow(display, id);
+    }
+
     XGrabServer(display);
     if (validatedrawable(id) && validateclient_mapped(id)) {
         XRemoveFromSaveSet(display, id);
@@ -241,6 +288,8 @@ WaWindow::~WaWindow(void) {
     if (name) delete [] name;
     if (host) delete [] host;
     if (pid) delete [] pid;
+    if (icon) icon->Release();
+    LISTDEL(req_queue);
     if (classhint && classhint->res_name) XFree(classhint->res_name);
     if (classhint && classhint->res_class) XFree(classhint->res_class);
 
@@ -302,6 +351,74 @@ list <WaAction *> *WaWindow::GetActionList(list<WaActionExtList *> *e) {
     return NULL;
 }
 
+/**
+ * @fn    ApplyRules(void)
+ * @brief Applies window rules
+ *
+ * Matches windows class name, class and title with window rules and
+ * applies all matching rules. This is done before the window is mapped,
+ * so the window is placed, decorated and stacked only once.
+ *
+ * @return Last matching rule with a merge target, NULL if no such rule
+ *         matched
+ */
+WaWindowRule *WaWindow::ApplyRules(void) {
+    WaWindowRule *merge_rule = NULL;
+    long int old_desktop_mask = desktop_mask;
+    bool geometry = false;
+
+    list<WaWindowRule *>::iterator it = wascreen->config.rules.begin();
+    for (; it != wascreen->config.rules.end(); ++it) {
+        WaWindowRule *r = *it;
+        if (! ((classhint &&
+                ((classhint->res_name && r->name->Match(classhint->res_name))
+                 || (classhint->res_class &&
+                     r->cl->Match(classhint->res_class)))) ||
+               r->title->Match(name)))
+            continue;
+
+        if (r->desktop_mask) desktop_mask = r->desktop_mask;
+        if (r->geometry) {
+            if (r->geometry & WidthValue) attrib.width = r->width;
+            if (r->geometry & HeightValue) attrib.height = r->height;
+            if (r->geometry & XValue)
+                attrib.x = (r->geometry & XNegative)?
+                    wascreen->width + r->x - attrib.width: r->x;
+            if (r->geometry & YValue)
+                attrib.y = (r->geometry & YNegative)?
+                    wascreen->height + r->y - attrib.height: r->y;
+            if (r->geometry & (XValue | YValue)) pos_init = true;
+            geometry = true;
+        }
+        if (r->decor_title != -1) flags.title = r->decor_title;
+        if (r->decor_handle != -1) flags.handle = r->decor_handle;
+        if (r->decor_border != -1) flags.border = r->decor_border;
+        if (r->sticky != -1) flags.sticky = r->sticky;
+        if (r->shaded != -1) flags.shaded = r->shaded;
+        if (r->tasklist != -1) flags.tasklist = r->tasklist;
+        if (r->focusable != -1) flags.focusable = r->focusable;
+        if (r->layer != -1) {
+            wascreen->aot_stacking_list.remove(frame->id);
+            wascreen->aab_stacking_list.remove(frame->id);
+            flags.alwaysontop = (r->layer == AlwaysontopLayer);
+            flags.alwaysatbottom = (r->layer == AlwaysatbottomLayer);
+            if (flags.alwaysontop)
+                wascreen->aot_stacking_list.push_back(frame->id);
+            else if (flags.alwaysatbottom)
+                wascreen->aab_stacking_list.push_back(frame->id);
+        }
+        if (r->merge) merge_rule = r;
+    }
+    flags.all = flags.title && flags.handle && flags.border;
+
+    if (geometry) InitPosition();
+    if (desktop_mask != old_desktop_mask) {
+        net->SetDesktop(this);
+        net->SetDesktopMask(this);
+    }
+    return merge_rule;
+}
+
 /**
  * @fn    SetActionLists(void)
  * @brief Set all actions lists
@@ -439,6 +556,7 @@ void WaWindow::MapWindow(void) {
         hidden = true;
     }
     mapped = true;
+    ShadeClients();
 }
 
 /**
@@ -543,6 +661,24 @@ void WaWindow::UpdateTitlebar(void) {
     }
 }
 
+/**
+ * @fn    SetName(char *n)
+ * @brief Sets window title
+ *
+ * Replaces window title with n and updates title text. Text is shaped
+ * right away for the focused and unfocused title fonts and then kept until
+ * the title changes.
+ *
+ * @param n New title, WaWindow takes ownership of it
+ */
+void WaWindow::SetName(char *n) {
+    delete [] name;
+    name = n;
+    name_text.Set(name);
+    name_text.Run(display, &wascreen->wstyle.wa_font);
+    name_text.Run(display, &wascreen->wstyle.wa_font_u);
+}
+
 /**
  * @fn    UpdateAllAttributes(void)
  * @brief Updates all window attrubutes
@@ -698,6 +834,7 @@ void WaWindow::UpdateAllAttributes(void) {
     Shape();
 #endif // SHAPE
 
+    net->SetFrameExtents(this);
 }
 
 /**
@@ -935,6 +1072,74 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
     if (resize) Shape();
 #endif // SHAPE
 
+    ShadeClients();
+}
+
+/**
+ * @fn    FocusClient(void)
+ * @brief Gives input focus to client
+ *
+ * Sets input focus and sends WM_TAKE_FOCUS message after the input model
+ * of the client, using the timestamp of the event being handled. No
+ * server grab is done, errors caused by windows that have been destroyed
+ * are ignored by the error handler and the window is removed when the
+ * DestroyNotify event arrives.
+ */
+void WaWindow::FocusClient(void) {
+    Time t = waimea->eh->last_time;
+
+    if (client_unmapped) {
+        XSetInputFocus(display, (master)? master->frame->id: frame->id,
+                       RevertToPointerRoot, t);
+        return;
+    }
+    if (input_hint)
+        XSetInputFocus(display, id, RevertToPointerRoot, t);
+    if (take_focus) {
+        XEvent ev;
+
+        ev.type = ClientMessage;
+        ev.xclient.window = id;
+        ev.xclient.message_type = net->wm_protocols;
+        ev.xclient.format = 32;
+        ev.xclient.data.l[0] = net->wm_take_focus;
+        ev.xclient.data.l[1] = t;
+        ev.xclient.data.l[2] = ev.xclient.data.l[3] =
+            ev.xclient.data.l[4] = 0;
+        XSendEvent(display, id, false, NoEventMask, &ev);
+    }
+}
+
+/**
+ * @fn    ShadeClients(void)
+ * @brief Unmaps or maps client windows after shade state
+ *
+ * Client windows are unmapped while window is shaded so that they don't
+ * keep drawing and receiving exposure events for contents that can't be
+ * seen, and they are mapped again when window is unshaded. WM_STATE is
+ * left untouched and the UnmapNotify events we cause are ignored so that
+ * this isn't taken as the client withdrawing. If client has focus, focus
+ * is kept on frame while client is unmapped.
+ */
+void WaWindow::ShadeClients(void) {
+    if (master) return;
+
+    MERGED_LOOP {
+        if (! _mw->mapped) continue;
+        if (flags.shaded && ! _mw->client_unmapped) {
+            _mw->client_unmapped = true;
+            _mw->ign_unmap++;
+            XUnmapWindow(display, _mw->id);
+            if (_mw->has_focus)
+                XSetInputFocus(display, frame->id, RevertToPointerRoot,
+                               waimea->eh->last_time);
+        }
+        else if (! flags.shaded && _mw->client_unmapped) {
+            _mw->client_unmapped = false;
+            XMapWindow(display, _mw->id);
+            if (_mw->has_focus) _mw->FocusClient();
+        }
+    }
 }
 
 /**
@@ -958,7 +1163,7 @@ void WaWindow::ReparentWin(void) {
 
         attrib_set.event_mask =
             PropertyChangeMask | StructureNotifyMask | FocusChangeMask |
-            EnterWindowMask | LeaveWindowMask;
+            EnterWindowMask | LeaveWindowMask | ColormapChangeMask;
         attrib_set.do_not_propagate_mask =
             ButtonPressMask | ButtonReleaseMask | ButtonMotionMask;
         attrib_set.backing_store = NotUseful;
@@ -998,12 +1203,14 @@ void WaWindow::UpdateGrabs(void) {
         list<WaAction *>::iterator it = actionlist->begin();
         for (; it != actionlist->end(); ++it) {
             if ((*it)->type == ButtonPress || (*it)->type == ButtonRelease ||
-                (*it)->type == DoubleClick) {
+                (*it)->type == DoubleClick || (*it)->type == TripleClick ||
+                (*it)->type == ButtonHold || (*it)->type == ButtonDrag) {
                 XGrabButton(display, (*it)->detail ? (*it)->detail: AnyButton,
                             AnyModifier, id, true, ButtonPressMask |
                             ButtonReleaseMask | ButtonMotionMask,
                             GrabModeSync, GrabModeSync, None, None);
             } else if ((*it)->type == KeyPress || (*it)->type == KeyRelease) {
+                if ((*it)->keysym != NoSymbol && ! (*it)->detail) continue;
                 XGrabKey(display, (*it)->detail ? (*it)->detail: AnyKey,
                          AnyModifier, id, true, GrabModeSync, GrabModeSync);
             }
@@ -1012,6 +1219,38 @@ void WaWindow::UpdateGrabs(void) {
     XUngrabServer(display);
 }
 
+/**
+ * @fn    UpdateKeyGrabs(map<KeySym, unsigned int> *changed)
+ * @brief Update passive key grabs
+ *
+ * Moves passive key grabs of key actions which keysyms are in changed to
+ * their new keycodes. Old keycodes are ungrabbed if no other action
+ * still uses them.
+ *
+ * @param changed Changed keysyms mapped to their old keycodes
+ */
+void WaWindow::UpdateKeyGrabs(map<KeySym, unsigned int> *changed) {
+    if (! validateclient_mapped(id)) return;
+
+    list<WaAction *>::iterator it = actionlist->begin();
+    for (; it != actionlist->end(); ++it) {
+        map<KeySym, unsigned int>::iterator cit =
+            changed->find((*it)->keysym);
+        if (cit == changed->end()) continue;
+
+        bool used = false;
+        list<WaAction *>::iterator uit = actionlist->begin();
+        for (; uit != actionlist->end() && ! used; ++uit)
+            if ((*uit)->keysym != NoSymbol && (*uit)->detail == cit->second)
+                used = true;
+        if (cit->second && ! used)
+            XUngrabKey(display, cit->second, AnyModifier, id);
+        if ((*it)->detail)
+            XGrabKey(display, (*it)->detail, AnyModifier, id, true,
+                     GrabModeSync, GrabModeSync);
+    }
+}
+
 #ifdef SHAPE
 /**
  * @fn    Shape(void)
@@ -1175,57 +1414,21 @@ void WaWindow::SendConfig(void) {
  * @fn    CreateOutline(void)
  * @brief Creates window outline
  *
- * Creates four windows used for displaying an outline when doing
- * non opaque moving and resizing of the window.
+ * Starts displaying the screen outline when doing non opaque moving and
+ * resizing of the window.
  */
 void WaWindow::CreateOutline(void) {
-    XSetWindowAttributes attrib_set;
-
-    int create_mask = CWOverrideRedirect | CWBackPixel | CWEventMask |
-        CWColormap;
-    attrib_set.background_pixel = wascreen->wstyle.outline_color.getPixel();
-    attrib_set.colormap = wascreen->colormap;
-    attrib_set.override_redirect = true;
-    attrib_set.event_mask = NoEventMask;
-
-    o_west = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                           screen_number, CopyFromParent, wascreen->visual,
-                           create_mask, &attrib_set);
-    o_east = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                           screen_number, CopyFromParent, wascreen->visual,
-                           create_mask, &attrib_set);
-    o_north = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                            screen_number, CopyFromParent, wascreen->visual,
-                            create_mask, &attrib_set);
-    o_south = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
-                            screen_number, CopyFromParent, wascreen->visual,
-                            create_mask, &attrib_set);
-    wascreen->aot_stacking_list.push_front(o_west);
-    wascreen->aot_stacking_list.push_front(o_east);
-    wascreen->aot_stacking_list.push_front(o_north);
-    wascreen->aot_stacking_list.push_front(o_south);
-    XMapWindow(display, o_west);
-    XMapWindow(display, o_east);
-    XMapWindow(display, o_north);
-    XMapWindow(display, o_south);
-    wascreen->RestackWindows(o_west);
+    wascreen->outline->Map();
 }
 
 /**
  * @fn    DestroyOutline(void)
  * @brief Destroys window outline
  *
- * Destorys the four outline windows.
+ * Hides the screen outline.
  */
 void WaWindow::DestroyOutline(void) {
-    wascreen->aot_stacking_list.remove(o_west);
-    wascreen->aot_stacking_list.remove(o_east);
-    wascreen->aot_stacking_list.remove(o_north);
-    wascreen->aot_stacking_list.remove(o_south);
-    XDestroyWindow(display, o_west);
-    XDestroyWindow(display, o_east);
-    XDestroyWindow(display, o_north);
-    XDestroyWindow(display, o_south);
+    wascreen->outline->Unmap();
 }
 
 /**
@@ -1242,17 +1445,11 @@ void WaWindow::DestroyOutline(void) {
 void WaWindow::DrawOutline(int x, int y, int width, int height) {
     int bw = (border_w) ? border_w: 2;
 
-    XResizeWindow(display, o_west, bw, bw * 2 + title_w + handle_w + height +
-                  border_w * 2);
-    XResizeWindow(display, o_east, bw, bw * 2 + title_w + handle_w + height +
-                  border_w * 2);
-    XResizeWindow(display, o_north, width + bw * 2, bw);
-    XResizeWindow(display, o_south, width + bw * 2, bw);
-
-    XMoveWindow(display, o_west, x - bw, y - title_w - border_w - bw);
-    XMoveWindow(display, o_east, x + width, y - title_w - border_w - bw);
-    XMoveWindow(display, o_north, x - bw, y - title_w - border_w - bw);
-    XMoveWindow(display, o_south, x - bw, y + height + handle_w + border_w);
+    wascreen->outline->Clear();
+    wascreen->outline->AddFrame(x - bw, y - title_w - border_w - bw,
+                                width + bw * 2, bw * 2 + title_w + handle_w +
+                                height + border_w * 2, bw);
+    wascreen->outline->Draw();
 }
 
 /**
@@ -1388,7 +1585,8 @@ void WaWindow::ButtonPressed(WaChildWindow *button) {
  * Given a new width and height this functions calculates if the windows
  * increasement sizes allows a resize of the window. The n_w parameter
  * is used for returning allowed width and the n_h parameter is used for
- * returning allowed height.
+ * returning allowed height. Allowed size is constrained by the ICCCM size
+ * hints of the window, see ConstrainSize().
  *
  * @param width Width we want to resize to
  * @param height Height we want to resize to
@@ -1407,10 +1605,7 @@ bool WaWindow::IncSizeCheck(int width, int height, int *n_w, int *n_h) {
         attrib.width == width) {
         if (width >= size.min_width && width <= size.max_width) {
             resize = true;
-            if (size.width_inc == 1)
-                *n_w = width;
-            else
-                *n_w = width - ((width - size.base_width) % size.width_inc);
+            *n_w = width;
         }
     }
     if ((height <= -(handle_w + border_w * 2)) && title_w) {
@@ -1427,6 +1622,7 @@ bool WaWindow::IncSizeCheck(int width, int height, int *n_w, int *n_h) {
         }
         *n_h = -(handle_w + border_w);
         if (handle_w) *n_h -= border_w;
+        if (resize) ConstrainSize(n_w, n_h);
         return resize;
     }
     if ((height >= (attrib.height + size.height_inc)) ||
@@ -1446,11 +1642,7 @@ bool WaWindow::IncSizeCheck(int width, int height, int *n_w, int *n_h) {
                 }
                 wascreen->UpdateCheckboxes(ShadeCBoxType);
             }
-            if (size.height_inc == 1)
-                *n_h = height;
-            else
-                *n_h = height -
-                    ((height - size.base_height) % size.height_inc);
+            *n_h = height;
         }
         else if (height >= size.min_height && height <= size.max_height) {
             resize = true;
@@ -1466,16 +1658,74 @@ bool WaWindow::IncSizeCheck(int width, int height, int *n_w, int *n_h) {
                 }
                 wascreen->UpdateCheckboxes(ShadeCBoxType);
             }
-            if (size.height_inc == 1)
-                *n_h = height;
-            else
-                *n_h = height -
-                    ((height - size.base_height) % size.height_inc);
+            *n_h = height;
         }
     }
+    if (resize) ConstrainSize(n_w, n_h);
     return resize;
 }
 
+/**
+ * @fn    ConstrainSize(int *w, int *h)
+ * @brief Applies ICCCM size constraints
+ *
+ * Rounds size down to base size plus a multiple of the resize increments
+ * and adjusts it to fit the aspect ratio range of the window, preferring
+ * to shrink the size. Aspect ratio is ignored while the window is shaded.
+ *
+ * @param w Width to constrain, returns constrained width
+ * @param h Height to constrain, returns constrained height
+ */
+void WaWindow::ConstrainSize(int *w, int *h) {
+    int dw = *w - size.base_width;
+    int dh = *h - size.base_height;
+    if (dw > 0) dw -= dw % size.width_inc;
+    if (dh > 0) dh -= dh % size.height_inc;
+
+    if (! flags.shaded && (size.min_aspect_x || size.max_aspect_x)) {
+        int aw = (size.base_size)? 0: size.base_width;
+        int ah = (size.base_size)? 0: size.base_height;
+        double ratio, v;
+
+        if (size.min_aspect_x &&
+            (double) (dw + aw) * size.min_aspect_y <
+            (double) (dh + ah) * size.min_aspect_x) {
+            ratio = (double) size.min_aspect_y / size.min_aspect_x;
+            int nh = (int) ((dw + aw) * ratio) - ah;
+            nh -= nh % size.height_inc;
+            if (nh + size.base_height >= size.min_height) dh = nh;
+            else {
+                v = (dh + ah) / ratio - aw;
+                dw = (int) v + ((v > (int) v)? 1: 0);
+                if (dw % size.width_inc)
+                    dw += size.width_inc - dw % size.width_inc;
+            }
+        }
+        if (size.max_aspect_x &&
+            (double) (dw + aw) * size.max_aspect_y >
+            (double) (dh + ah) * size.max_aspect_x) {
+            ratio = (double) size.max_aspect_x / size.max_aspect_y;
+            int nw = (int) ((dh + ah) * ratio) - aw;
+            nw -= nw % size.width_inc;
+            if (nw + size.base_width >= size.min_width) dw = nw;
+            else {
+                v = (dw + aw) / ratio - ah;
+                dh = (int) v + ((v > (int) v)? 1: 0);
+                if (dh % size.height_inc)
+                    dh += size.height_inc - dh % size.height_inc;
+            }
+        }
+    }
+
+    if (size.base_width + dw > size.max_width)
+        dw = size.max_width - size.base_width;
+    if (size.base_height + dh > size.max_height)
+        dh = size.max_height - size.base_height;
+
+    *w = size.base_width + dw;
+    if (! flags.shaded) *h = size.base_height + dh;
+}
+
 /**
  * @fn    Raise(XEvent *, WaAction *)
  * @brief Raises the window
@@ -1582,12 +1832,8 @@ void WaWindow::Focus(bool vis) {
             }
             if (mergedback) ToFront(NULL, NULL);
         } else if (mergedback) return;
-        XInstallColormap(display, attrib.colormap);
-        XGrabServer(display);
-        if (validateclient_mapped(id)) {
-            XSetInputFocus(display, id, RevertToPointerRoot, CurrentTime);
-        } else DELETED;
-        XUngrabServer(display);
+        wascreen->InstallColormap(attrib.colormap);
+        FocusClient();
     } else
         want_focus = true;
 }
@@ -1604,7 +1850,7 @@ void WaWindow::Focus(bool vis) {
 void WaWindow::Move(XEvent *e, WaAction *) {
     WaWindow *w;
     XEvent event, *map_ev;
-    int px, py, nx, ny, i;
+    int px, py, nx, ny, sx, sy, i;
     list<XEvent *> *maprequest_list;
     bool started = false;
     Window wd;
@@ -1652,6 +1898,10 @@ void WaWindow::Move(XEvent *e, WaAction *) {
         }
     } else DELETED;
     XUngrabServer(display);
+    SnapEdges snap(w, wascreen->config.snap_distance,
+                   wascreen->config.edge_resistance);
+    sx = nx;
+    sy = ny;
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -1662,11 +1912,14 @@ void WaWindow::Move(XEvent *e, WaAction *) {
                 ny += event.xmotion.y_root - py;
                 px  = event.xmotion.x_root;
                 py  = event.xmotion.y_root;
+                sx = nx;
+                sy = ny;
+                snap.Move(&sx, &sy, w->attrib.width, w->attrib.height);
                 if (! started) {
                     w->CreateOutline();
                     started = true;
                 }
-                w->DrawOutline(nx, ny, w->attrib.width, w->attrib.height);
+                w->DrawOutline(sx, sy, w->attrib.width, w->attrib.height);
                 break;
             case LeaveNotify:
             case EnterNotify:
@@ -1675,6 +1928,7 @@ void WaWindow::Move(XEvent *e, WaAction *) {
                     wascreen->north->id == event.xcrossing.window ||
                     wascreen->south->id == event.xcrossing.window) {
                     waimea->eh->HandleEvent(&event);
+                    snap.Update();
                 } else if (event.type == LeaveNotify) {
                     int cx, cy;
                     XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
@@ -1683,11 +1937,14 @@ void WaWindow::Move(XEvent *e, WaAction *) {
                     ny += cy - py;
                     px = cx;
                     py = cy;
+                    sx = nx;
+                    sy = ny;
+                    snap.Move(&sx, &sy, w->attrib.width, w->attrib.height);
                     if (! started) {
                         w->CreateOutline();
                         started = true;
                     }
-                    w->DrawOutline(nx, ny, w->attrib.width, w->attrib.height);
+                    w->DrawOutline(sx, sy, w->attrib.width, w->attrib.height);
                 }
                 break;
             case DestroyNotify:
@@ -1726,11 +1983,11 @@ void WaWindow::Move(XEvent *e, WaAction *) {
                 if (event.type == KeyPress || event.type == KeyRelease)
                     event.xkey.window = w->id;
                 waimea->eh->HandleEvent(&event);
-                w->DrawOutline(nx, ny, attrib.width, attrib.height);
+                w->DrawOutline(sx, sy, attrib.width, attrib.height);
                 if (waimea->eh->move_resize != EndMoveResizeType) break;
                 if (started) w->DestroyOutline();
-                w->attrib.x = nx;
-                w->attrib.y = ny;
+                w->attrib.x = sx;
+                w->attrib.y = sy;
                 w->RedrawWindow();
                 CheckMoveMerge(w->attrib.x, w->attrib.y);
                 while (! maprequest_list->empty()) {
@@ -1839,6 +2096,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
         }
     } else { deleted = true; XUngrabServer(display); return false; }
     XUngrabServer(display);
+    SnapEdges snap(w, wascreen->config.snap_distance,
+                   wascreen->config.edge_resistance);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -1874,6 +2133,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                         w->attrib.x = nx;
                         w->attrib.y = ny;
                     }
+                    snap.Move(&w->attrib.x, &w->attrib.y, w->attrib.width,
+                              w->attrib.height);
                     w->RedrawWindow();
                 }
                 break;
@@ -1884,6 +2145,7 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                     wascreen->north->id == event.xcrossing.window ||
                     wascreen->south->id == event.xcrossing.window) {
                     waimea->eh->HandleEvent(&event);
+                    snap.Update();
                 } else if (event.type == LeaveNotify) {
                     unsigned int ui;
                     Window wd;
@@ -1920,6 +2182,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                             w->attrib.x = nx;
                             w->attrib.y = ny;
                         }
+                        snap.Move(&w->attrib.x, &w->attrib.y,
+                                  w->attrib.width, w->attrib.height);
                         w->RedrawWindow();
                     }
                 }
@@ -2013,7 +2277,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
  */
 void WaWindow::Resize(XEvent *e, int how) {
     XEvent event, *map_ev;
-    int px, py, width, height, n_w, n_h, o_w, o_h, n_x, o_x, i;
+    int px, py, width, height, n_w, n_h, sn_w, sn_h, o_w, o_h, n_x, o_x;
+    int i;
     list<XEvent *> *maprequest_list;
     bool started = false;
     Window wd;
@@ -2063,6 +2328,8 @@ void WaWindow::Resize(XEvent *e, int how) {
         }
     } else DELETED;
     XUngrabServer(display);
+    SnapEdges snap(w, wascreen->config.snap_distance,
+                   wascreen->config.edge_resistance);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -2073,7 +2340,12 @@ void WaWindow::Resize(XEvent *e, int how) {
                 height += event.xmotion.y_root - py;
                 px = event.xmotion.x_root;
                 py = event.xmotion.y_root;
-                if (w->IncSizeCheck(width, height, &n_w, &n_h)) {
+                sn_w = width;
+                sn_h = height;
+                snap.Resize((how > 0)? attrib.x:
+                            attrib.x + attrib.width, attrib.y,
+                            &sn_w, &sn_h, how);
+                if (w->IncSizeCheck(sn_w, sn_h, &n_w, &n_h)) {
                     if (how == WestType) n_x -= n_w - o_w;
                     if (! started) {
                         CreateOutline();
@@ -2096,6 +2368,7 @@ void WaWindow::Resize(XEvent *e, int how) {
                     waimea->eh->HandleEvent(&event);
                     px -= (wascreen->v_x - old_vx);
                     py -= (wascreen->v_y - old_vy);
+                    snap.Update();
                     n_x = attrib.x;
                     if (how == WestType) n_x -= n_w - attrib.width;
                     DrawOutline(n_x, attrib.y, n_w, n_h);
@@ -2107,7 +2380,12 @@ void WaWindow::Resize(XEvent *e, int how) {
                     height += cy - py;
                     px = cx;
                     py = cy;
-                    if (IncSizeCheck(width, height, &n_w, &n_h)) {
+                    sn_w = width;
+                    sn_h = height;
+                    snap.Resize((how > 0)? attrib.x:
+                                attrib.x + attrib.width, attrib.y,
+                                &sn_w, &sn_h, how);
+                    if (IncSizeCheck(sn_w, sn_h, &n_w, &n_h)) {
                         if (how == WestType) n_x -= n_w - o_w;
                         if (! started) {
                             CreateOutline();
@@ -2196,7 +2474,7 @@ void WaWindow::Resize(XEvent *e, int how) {
  */
 void WaWindow::ResizeOpaque(XEvent *e, int how) {
     XEvent event, *map_ev;
-    int px, py, width, height, n_w, n_h, i, sw, sh;
+    int px, py, width, height, n_w, n_h, sn_w, sn_h, i, sw, sh;
     list<XEvent *> *maprequest_list;
     Window wd;
     unsigned int ui;
@@ -2246,6 +2524,8 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
         }
     } else DELETED;
     XUngrabServer(display);
+    SnapEdges snap(w, wascreen->config.snap_distance,
+                   wascreen->config.edge_resistance);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -2256,7 +2536,12 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
                 height += event.xmotion.y_root - py;
                 px = event.xmotion.x_root;
                 py = event.xmotion.y_root;
-                if (w->IncSizeCheck(width, height, &n_w, &n_h)) {
+                sn_w = width;
+                sn_h = height;
+                snap.Resize((how > 0)? w->attrib.x:
+                            w->attrib.x + w->attrib.width, w->attrib.y,
+                            &sn_w, &sn_h, how);
+                if (w->IncSizeCheck(sn_w, sn_h, &n_w, &n_h)) {
                     if (how == WestType) w->attrib.x -= n_w - attrib.width;
                     w->attrib.width  = n_w;
                     w->attrib.height = n_h;
@@ -2280,6 +2565,7 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
                     waimea->eh->HandleEvent(&event);
                     px -= (wascreen->v_x - old_vx);
                     py -= (wascreen->v_y - old_vy);
+                    snap.Update();
                 } else if (event.type == LeaveNotify) {
                     int cx, cy;
                     XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
@@ -2288,7 +2574,12 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
                     height += cy - py;
                     px = cx;
                     py = cy;
-                    if (w->IncSizeCheck(width, height, &n_w, &n_h)) {
+                    sn_w = width;
+                    sn_h = height;
+                    snap.Resize((how > 0)? w->attrib.x:
+                                w->attrib.x + w->attrib.width, w->attrib.y,
+                                &sn_w, &sn_h, how);
+                    if (w->IncSizeCheck(sn_w, sn_h, &n_w, &n_h)) {
                         if (how == WestType)
                             w->attrib.x -= n_w - attrib.width;
                         w->attrib.width  = n_w;
@@ -2546,29 +2837,46 @@ void WaWindow::Kill(XEvent *, WaAction *) {
 }
 
 /**
- * @fn    CloseKill(XEvent *e, WaAction *ac)
- * @brief Close/Kill the window
+ * @fn    AcceptsDelete(void)
+ * @brief Checks for WM_DELETE_WINDOW protocol
  *
- * Checks if the window will accept a delete message. If it will, then we
- * use that method for closing the window otherwise we use the kill method.
+ * Marks the window as deleted if the client window no longer exists.
  *
- * @param e XEvent causing close/kill of window
- * @param ac WaAction object
+ * @return True if the window will accept a delete message, otherwise false
  */
-void WaWindow::CloseKill(XEvent *e, WaAction *ac) {
+bool WaWindow::AcceptsDelete(void) {
     int i, n;
-    bool close = false;
+    bool accept = false;
     Atom *protocols;
     Atom del_atom = XInternAtom(display, "WM_DELETE_WINDOW", false);
 
     XGrabServer(display);
     if (validatedrawable(id)) {
         if (XGetWMProtocols(display, id, &protocols, &n)) {
-            for (i = 0; i < n; i++) if (protocols[i] == del_atom) close = true;
+            for (i = 0; i < n; i++)
+                if (protocols[i] == del_atom) accept = true;
             XFree(protocols);
         }
-    } else DELETED;
+    } else deleted = true;
     XUngrabServer(display);
+
+    return accept;
+}
+
+/**
+ * @fn    CloseKill(XEvent *e, WaAction *ac)
+ * @brief Close/Kill the window
+ *
+ * Checks if the window will accept a delete message. If it will, then we
+ * use that method for closing the window otherwise we use the kill method.
+ *
+ * @param e XEvent causing close/kill of window
+ * @param ac WaAction object
+ */
+void WaWindow::CloseKill(XEvent *e, WaAction *ac) {
+    bool close = AcceptsDelete();
+
+    if (deleted) return;
     if (close) Close(e, ac);
     else Kill(e, ac);
 }
@@ -2818,16 +3126,7 @@ void WaWindow::ToggleSticky(XEvent *, WaAction *) {
 void WaWindow::Minimize(XEvent *, WaAction *) {
     if (master) { master->Minimize(NULL, NULL); return; }
     if (flags.hidden) return;
-    MERGED_LOOP {
-        net->SetState(_mw, IconicState);
-        net->SetWmState(_mw);
-        if (title_w) {
-            list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
-            for (; bit != _mw->buttons.end(); ++bit)
-                if ((*bit)->bstyle->cb == MinCBoxType)
-                    (*bit)->Render();
-        }
-    }
+    SetMinimizeState(IconicState);
     wascreen->UpdateCheckboxes(MinCBoxType);
 }
 
@@ -2840,8 +3139,23 @@ void WaWindow::Minimize(XEvent *, WaAction *) {
 void WaWindow::UnMinimize(XEvent *, WaAction *) {
     if (master) { master->UnMinimize(NULL, NULL); return; }
     if (! flags.hidden) return;
+    SetMinimizeState(NormalState);
+    wascreen->UpdateCheckboxes(MinCBoxType);
+}
+
+/**
+ * @fn    SetMinimizeState(int state)
+ * @brief Sets minimize state
+ *
+ * Sets window and all merged windows in iconic or normal state and updates
+ * minimize checkbox buttons. Menu checkboxes are left for the caller to
+ * update.
+ *
+ * @param state IconicState or NormalState
+ */
+void WaWindow::SetMinimizeState(int state) {
     MERGED_LOOP {
-        net->SetState(_mw, NormalState);
+        net->SetState(_mw, state);
         net->SetWmState(_mw);
         if (title_w) {
             list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
@@ -2850,7 +3164,6 @@ void WaWindow::UnMinimize(XEvent *, WaAction *) {
                     (*bit)->Render();
         }
     }
-    wascreen->UpdateCheckboxes(MinCBoxType);
 }
 
 /**
@@ -3823,6 +4136,134 @@ void WaWindow::PartCurrentJoinDesktop(XEvent *, WaAction *ac) {
     }
 }
 
+/**
+ * @fn    GroupRaise(XEvent *, WaAction *)
+ * @brief Raises application group
+ *
+ * Raises all windows in the same application group as this window. If
+ * window isn't part of a group only the window itself is raised.
+ */
+void WaWindow::GroupRaise(XEvent *e, WaAction *ac) {
+    if (! group) { Raise(e, ac); return; }
+    wascreen->RaiseGroup(group);
+}
+
+/**
+ * @fn    GroupLower(XEvent *, WaAction *)
+ * @brief Lowers application group
+ *
+ * Lowers all windows in the same application group as this window. If
+ * window isn't part of a group only the window itself is lowered.
+ */
+void WaWindow::GroupLower(XEvent *e, WaAction *ac) {
+    if (! group) { Lower(e, ac); return; }
+    wascreen->LowerGroup(group);
+}
+
+/**
+ * @fn    GroupMinimize(XEvent *, WaAction *)
+ * @brief Minimizes application group
+ *
+ * Sets all windows in the same application group as this window in iconic
+ * state.
+ */
+void WaWindow::GroupMinimize(XEvent *e, WaAction *ac) {
+    if (! group) { Minimize(e, ac); return; }
+    list<WaWindow *> members;
+    wascreen->GroupMembers(group, &members);
+    list<WaWindow *>::iterator it = members.begin();
+    for (; it != members.end(); ++it)
+        if (! (*it)->flags.hidden) (*it)->SetMinimizeState(IconicState);
+    wascreen->UpdateCheckboxes(MinCBoxType);
+}
+
+/**
+ * @fn    GroupUnMinimize(XEvent *, WaAction *)
+ * @brief Restores application group
+ *
+ * Sets all windows in the same application group as this window in normal
+ * state.
+ */
+void WaWindow::GroupUnMinimize(XEvent *e, WaAction *ac) {
+    if (! group) { UnMinimize(e, ac); return; }
+    list<WaWindow *> members;
+    wascreen->GroupMembers(group, &members);
+    list<WaWindow *>::iterator it = members.begin();
+    for (; it != members.end(); ++it)
+        if ((*it)->flags.hidden) (*it)->SetMinimizeState(NormalState);
+    wascreen->UpdateCheckboxes(MinCBoxType);
+}
+
+/**
+ * @fn    GroupClose(XEvent *, WaAction *)
+ * @brief Closes application group
+ *
+ * Closes all windows in the same application group as this window. Windows
+ * not accepting delete messages are collected and their clients killed
+ * once each. Killing a client destroys all its windows, so windows that
+ * are gone when their turn comes belonged to an already killed client.
+ */
+void WaWindow::GroupClose(XEvent *e, WaAction *ac) {
+    if (! group) { CloseKill(e, ac); return; }
+    list<WaWindow *> members = wascreen->groups[group], kill;
+    list<WaWindow *>::iterator it = members.begin();
+    for (; it != members.end(); ++it) {
+        if ((*it)->AcceptsDelete()) (*it)->Close(e, ac);
+        else if (! (*it)->deleted) kill.push_back(*it);
+    }
+    XGrabServer(display);
+    for (it = kill.begin(); it != kill.end(); ++it) {
+        if (validatedrawable((*it)->id))
+            XKillClient(display, (*it)->id);
+        else
+            (*it)->deleted = true;
+    }
+    XUngrabServer(display);
+}
+
+/**
+ * @fn    GroupPartCurrentJoinDesktop(XEvent *, WaAction *ac)
+ * @brief Moves application group to desktop
+ *
+ * Makes all windows in the same application group as this window part
+ * current desktop and join desktop specified by parameter. Desktop hints
+ * for the whole group are written in one pass.
+ *
+ * @param ac WaAction object
+ */
+void WaWindow::GroupPartCurrentJoinDesktop(XEvent *e, WaAction *ac) {
+    if (! group) { PartCurrentJoinDesktop(e, ac); return; }
+    if (! ac->param) return;
+    unsigned int desk = (unsigned int) atoi(ac->param);
+    if (desk >= wascreen->config.desktops) return;
+    long int current = 1L << wascreen->current_desktop->number;
+
+    list<WaWindow *> members, changed;
+    wascreen->GroupMembers(group, &members);
+    WaWindow *focused = NULL;
+    list<WaWindow *>::iterator it = members.begin();
+    for (; it != members.end(); ++it) {
+        WaWindow *ww = *it;
+        ww->desktop_mask = (ww->desktop_mask & ~current) | (1L << desk);
+        list<WaWindow *>::iterator mit = ww->merged.begin();
+        for (; mit != ww->merged.end(); ++mit) {
+            (*mit)->desktop_mask = ww->desktop_mask;
+            changed.push_back(*mit);
+        }
+        changed.push_back(ww);
+
+        if (ww->desktop_mask & current)
+            ww->Show();
+        else if (ww->has_focus)
+            focused = ww;
+        else
+            ww->Hide();
+    }
+    if (focused) focused->Hide();
+
+    if (! changed.empty()) net->SetDesktops(&changed);
+}
+
 /**
  * @fn    Merge(WaWindow *child, int mtype)
  * @brief Merges a child window
@@ -3849,7 +4290,7 @@ void WaWindow::Merge(WaWindow *child, int mtype) {
                         -child->attrib.width, -child->attrib.height);
         XSelectInput(display, child->id, PropertyChangeMask |
                      StructureNotifyMask | FocusChangeMask |
-                     EnterWindowMask | LeaveWindowMask);
+                     EnterWindowMask | LeaveWindowMask | ColormapChangeMask);
     } else {
         XUngrabServer(display);
         return;
@@ -3907,7 +4348,7 @@ void WaWindow::Unmerge(WaWindow *child) {
                         child->title_w + child->border_w);
         XSelectInput(display, child->id, PropertyChangeMask |
                      StructureNotifyMask | FocusChangeMask |
-                     EnterWindowMask | LeaveWindowMask);
+                     EnterWindowMask | LeaveWindowMask | ColormapChangeMask);
     }
     XUngrabServer(display);
 
@@ -4218,6 +4659,14 @@ void WaWindow::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
                     (! ((*it)->mod & MoveResizeMask)))
                     wait_release = match = true;
             }
+            EventDetail ped = *ed;
+            for (it = acts->begin(); it != acts->end(); ++it) {
+                if ((*it)->mod & MoveResizeMask) continue;
+                ped.type = ButtonHold;
+                if (eventmatch(*it, &ped)) wait_release = match = true;
+                ped.type = ButtonDrag;
+                if (eventmatch(*it, &ped)) wait_release = match = true;
+            }
         }
         else if (ed->type == KeyPress) {
             for (; it != acts->end(); ++it) {
@@ -4236,12 +4685,14 @@ void WaWindow::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
             match = true;
             XAutoRepeatOn(display);
             if ((*it)->replay && ! wait_release) replay = true;
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+            if ((*it)->seq)
+                waimea->eh->StartKeySequence((*it)->seq, e, id);
+            else if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
                 Interrupt *i = new Interrupt(*it, e, id);
                 waimea->timer->AddInterrupt(i);
             } else {
                 if ((*it)->exec)
-                    waexec((*it)->exec, wascreen->displaystring);
+                    waexec((*it)->exec, wascreen);
                 else
                     ((*this).*((*it)->winfunc))(e, *it);
             }
@@ -4260,7 +4711,7 @@ void WaWindow::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
     switch (etype) {
         case WindowType:
             if (ed->type == ButtonPress || ed->type == ButtonRelease ||
-                ed->type == DoubleClick) {
+                ed->type == DoubleClick || ed->type == TripleClick) {
                 if (replay || ! match)
                     XAllowEvents(display, ReplayPointer, e->xbutton.time);
                 else
@@ -4309,6 +4760,7 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
     ic = wascreen->ic;
 
     pressed = false;
+    f_texture = u_texture = NULL;
     int create_mask = CWOverrideRedirect | CWBorderPixel | CWEventMask |
         CWColormap;
     attrib_set.border_pixel = wa->wascreen->wstyle.border_color.getPixel();
@@ -4323,9 +4775,15 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
 
     switch (type) {
         case FrameType:
-            attrib_set.event_mask |= SubstructureRedirectMask;
-            create_mask |= CWBackPixmap;
-            attrib_set.background_pixmap = ParentRelative;
+            attrib_set.event_mask |= SubstructureRedirectMask |
+                FocusChangeMask;
+            if (wascreen->argb_visual) {
+                create_mask |= CWBackPixel;
+                attrib_set.background_pixel = 0;
+            } else {
+                create_mask |= CWBackPixmap;
+                attrib_set.background_pixmap = ParentRelative;
+            }
             attrib.x = wa->attrib.x - wa->border_w;
             attrib.y = wa->attrib.y - wa->title_w - wa->border_w * 2;
             attrib.width = wa->attrib.width;
@@ -4340,10 +4798,12 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
         case TitleType:
             f_texture = &wascreen->wstyle.t_focus;
             u_texture = &wascreen->wstyle.t_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             break;
         case HandleType:
             f_texture = &wascreen->wstyle.h_focus;
             u_texture = &wascreen->wstyle.h_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             break;
         case ButtonType:
             attrib_set.event_mask |= ExposureMask;
@@ -4351,19 +4811,21 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
         case LGripType:
             f_texture = &wascreen->wstyle.g_focus;
             u_texture = &wascreen->wstyle.g_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             create_mask |= CWCursor;
             attrib_set.cursor = wa->waimea->resizeleft_cursor;
             break;
         case RGripType:
             f_texture = &wascreen->wstyle.g_focus;
             u_texture = &wascreen->wstyle.g_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             create_mask |= CWCursor;
             attrib_set.cursor = wa->waimea->resizeright_cursor;
             break;
     }
     id = XCreateWindow(display, parent, attrib.x, attrib.y,
-                       attrib.width, attrib.height, 0, CopyFromParent,
-                       CopyFromParent, CopyFromParent, create_mask,
+                       attrib.width, attrib.height, 0, wascreen->screen_depth,
+                       CopyFromParent, wascreen->visual, create_mask,
                        &attrib_set);
 
 #ifdef XFT
@@ -4411,11 +4873,13 @@ void WaChildWindow::Render(void) {
     XTranslateCoordinates(display, id, wa->wascreen->id, 0, 0, &pos_x, &pos_y,
                           &wd);
 
-    if (texture->getOpacity()) {
+    // with ARGB visual, translucency doesn't depend on window position
+    if (wa->render_if_opacity && IsDrawable() &&
+        (wascreen->argb_visual || ! texture->getOpacity())) return;
+    if (texture->getOpacity())
         xpixmap = XCreatePixmap(wascreen->pdisplay, wascreen->id,
                                 attrib.width, attrib.height,
                                 wascreen->screen_depth);
-    } else if (wa->render_if_opacity && IsDrawable()) return;
 #endif // RENDER
 
     switch (type) {
@@ -4474,7 +4938,7 @@ void WaChildWindow::Render(void) {
             break;
     }
     if (! done) {
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
+        if (texture->getTexture() & WaImage_Solid) {
             pixmap = None;
 #ifdef RENDER
             if (texture->getOpacity())
@@ -4543,20 +5007,27 @@ void WaChildWindow::Render(void) {
  * @param drawable Drawable to draw on
  */
 void WaChildWindow::Draw(Drawable drawable) {
-    int x = 0, y = 0, length, text_w;
+    int x = 0, y = 0, text_w;
+    WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
 
-    if (! drawable) XClearWindow(display, id);
+    if (! drawable) {
+        XClearWindow(display, id);
+        if (type != ButtonType && texture)
+            ic->drawSolid(id, attrib.width, attrib.height, texture);
+    }
     switch (type) {
         case TitleType:
             if (! drawable) return;
             if (wa->label->IsDrawable()) {
                 if (drawable == (Drawable) 2) {
-                    WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
                     XSetWindowBackground(display, id,
                                          texture->getColor()->getPixel());
-                } else
+                    XClearWindow(display, id);
+                    ic->drawSolid(id, attrib.width, attrib.height, texture);
+                } else {
                     XSetWindowBackgroundPixmap(display, id, drawable);
-                XClearWindow(display, id);
+                    XClearWindow(display, id);
+                }
                 return;
             }
             x = wa->label->g_x;
@@ -4578,24 +5049,20 @@ void WaChildWindow::Draw(Drawable drawable) {
                                       attrib.width, attrib.height,
                                       wascreen->screen_depth);
                 if (drawable == (Drawable) 2) {
-                    XGCValues values;
-                    WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
-                    values.foreground = texture->getColor()->getPixel();
-                    GC gc = XCreateGC(display, wascreen->id, GCForeground,
-                                      &values);
-                    XFillRectangle(display, p_tmp, gc, 0, 0, attrib.width,
-                                   attrib.height);
-                    XFreeGC(display, gc);
-                } else {
-                    GC gc = DefaultGC(display, wascreen->screen_number);
-                    XCopyArea(display, drawable, p_tmp, gc, 0, 0, attrib.width,
-                              attrib.height, 0, 0);
-                }
+                    XFillRectangle(display, p_tmp,
+                                   ic->getSolidGC(texture->getColor()->
+                                                  getPixel()),
+                                   0, 0, attrib.width, attrib.height);
+                    ic->drawSolid(p_tmp, attrib.width, attrib.height,
+                                  texture);
+                } else
+                    ic->fillImage(p_tmp, drawable, attrib.width,
+                                  attrib.height);
             }
-            length = strlen(wa->name);
             WaFont *wafont = (wa->has_focus)? &wascreen->wstyle.wa_font:
                 &wascreen->wstyle.wa_font_u;
-            text_w = wafont->Width(display, wa->name, length);
+            WaTextRun *run = wa->name_text.Run(display, wafont);
+            text_w = run->Width();
 
             if (text_w > (wa->label->attrib.width - 10)) x += 2;
             else {
@@ -4622,7 +5089,7 @@ void WaChildWindow::Draw(Drawable drawable) {
                          xftdraw,
 #endif // XFT
 
-                         x, y, wa->name, length);
+                         x, y, run, wa->label->attrib.width - 4);
 
             if (drawable) {
                 XSetWindowBackgroundPixmap(display, id, p_tmp);
@@ -4631,29 +5098,40 @@ void WaChildWindow::Draw(Drawable drawable) {
             }
         } break;
         case ButtonType: {
+            bool flag = false;
+            switch (bstyle->cb) {
+                case MaxCBoxType: flag = wa->flags.max; break;
+                case ShadeCBoxType: flag = wa->flags.shaded; break;
+                case StickCBoxType: flag = wa->flags.sticky; break;
+                case TitleCBoxType: flag = wa->flags.title; break;
+                case HandleCBoxType: flag = wa->flags.handle; break;
+                case BorderCBoxType: flag = wa->flags.border; break;
+                case AllCBoxType: flag = wa->flags.all; break;
+                case AOTCBoxType: flag = wa->flags.alwaysontop; break;
+                case AABCBoxType: flag = wa->flags.alwaysatbottom; break;
+            }
+            if (flag)
+                texture = (pressed) ? &bstyle->t_pressed2:
+                    ((wa->has_focus)? &bstyle->t_focused2:
+                     &bstyle->t_unfocused2);
+            else
+                texture = (pressed) ? &bstyle->t_pressed:
+                    ((wa->has_focus)? &bstyle->t_focused:
+                     &bstyle->t_unfocused);
+
             if (drawable) {
-                if (drawable == (Drawable) 2) {
-                    WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
+                if (drawable == (Drawable) 2)
                     XSetWindowBackground(display, id,
                                          texture->getColor()->getPixel());
-                } else
+                else
                     XSetWindowBackgroundPixmap(display, id, drawable);
                 XClearWindow(display, id);
             }
+            if (drawable == 0 || drawable == (Drawable) 2)
+                ic->drawSolid(id, attrib.width, attrib.height, texture);
+
             GC *gc;
             if (bstyle->fg) {
-                bool flag = false;
-                switch (bstyle->cb) {
-                    case MaxCBoxType: flag = wa->flags.max; break;
-                    case ShadeCBoxType: flag = wa->flags.shaded; break;
-                    case StickCBoxType: flag = wa->flags.sticky; break;
-                    case TitleCBoxType: flag = wa->flags.title; break;
-                    case HandleCBoxType: flag = wa->flags.handle; break;
-                    case BorderCBoxType: flag = wa->flags.border; break;
-                    case AllCBoxType: flag = wa->flags.all; break;
-                    case AOTCBoxType: flag = wa->flags.alwaysontop; break;
-                    case AABCBoxType: flag = wa->flags.alwaysatbottom; break;
-                }
                 if (flag) {
                     gc = (pressed) ? &bstyle->g_pressed2:
                         ((wa->has_focus)? &bstyle->g_focused2:
@@ -4708,12 +5186,14 @@ void WaChildWindow::Draw(Drawable drawable) {
         default:
             if (drawable) {
                 if (drawable == (Drawable) 2) {
-                    WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
                     XSetWindowBackground(display, id,
                                          texture->getColor()->getPixel());
-                } else
+                    XClearWindow(display, id);
+                    ic->drawSolid(id, attrib.width, attrib.height, texture);
+                } else {
                     XSetWindowBackgroundPixmap(display, id, drawable);
-                XClearWindow(display, id);
+                    XClearWindow(display, id);
+                }
             }
     }
 }
@@ -4774,9 +5254,279 @@ void WaWindow::NextDesktop(XEvent *, WaAction *) {
 void WaWindow::PreviousDesktop(XEvent *, WaAction *) {
     wascreen->PreviousDesktop(NULL, NULL);
 }
+void WaWindow::JoinDesktopMatch(XEvent *e, WaAction *ac) {
+    wascreen->JoinDesktopMatch(e, ac);
+}
+void WaWindow::PartDesktopMatch(XEvent *e, WaAction *ac) {
+    wascreen->PartDesktopMatch(e, ac);
+}
+void WaWindow::DesktopMaskMatch(XEvent *e, WaAction *ac) {
+    wascreen->DesktopMaskMatch(e, ac);
+}
 void WaWindow::Restart(XEvent *e, WaAction *ac) {
     wascreen->Restart(e, ac);
 }
 void WaWindow::Exit(XEvent *e, WaAction *ac) {
     wascreen->Exit(e, ac);
 }
+
+/**
+ * @fn    SnapEdges(WaWindow *ww, int dist, int resist)
+ * @brief Constructor for SnapEdges class
+ *
+ * Collects candidate edges for snapping a frame that is moved or resized.
+ * Screen, workarea and xinerama screen edges and outer edges of all other
+ * visible frames are stored in sorted x and y arrays, so that snapping an
+ * edge is a binary search. Nothing is snapped if snap distance is zero and
+ * no edge resists if edge resistance is zero.
+ *
+ * @param ww Window that is moved or resized
+ * @param dist Snap distance
+ * @param resist Edge resistance
+ */
+SnapEdges::SnapEdges(WaWindow *ww, int dist, int resist) {
+    wa = ww;
+    distance = dist;
+    resistance = resist;
+
+    left = ww->attrib.x - ww->frame->attrib.x;
+    top = ww->attrib.y - ww->frame->attrib.y;
+    right = ww->frame->attrib.x + ww->frame->attrib.width +
+        ww->border_w * 2 - (ww->attrib.x + ww->attrib.width);
+    bottom = ww->frame->attrib.y + ww->frame->attrib.height +
+        ww->border_w * 2 - (ww->attrib.y + ww->attrib.height);
+
+    Update();
+}
+
+/**
+ * @fn    Update(void)
+ * @brief Recollect candidate edges
+ *
+ * Rebuilds sorted edge arrays. Must be called when other frames have moved,
+ * e.g. after the viewport has changed. Edge resistance starts over from the
+ * next position.
+ */
+void SnapEdges::Update(void) {
+    WaScreen *ws = wa->wascreen;
+
+    xs.clear();
+    ys.clear();
+    tracking = false;
+    hold_x = hold_y = 0;
+
+    if (! distance && ! resistance) return;
+
+    xs.push_back(0);
+    xs.push_back(ws->width);
+    ys.push_back(0);
+    ys.push_back(ws->height);
+    Workarea *work = &ws->current_desktop->workarea;
+    if (work->x || work->width != ws->width) {
+        xs.push_back(work->x);
+        xs.push_back(work->x + work->width);
+    }
+    if (work->y || work->height != ws->height) {
+        ys.push_back(work->y);
+        ys.push_back(work->y + work->height);
+    }
+
+#ifdef XINERAMA
+    if (ws->waimea->xinerama && ws->waimea->xinerama_info) {
+        for (int i = 0; i < ws->waimea->xinerama_info_num; i++) {
+            XineramaScreenInfo *xi = &ws->waimea->xinerama_info[i];
+            xs.push_back(xi->x_org);
+            xs.push_back(xi->x_org + xi->width);
+            ys.push_back(xi->y_org);
+            ys.push_back(xi->y_org + xi->height);
+        }
+    }
+#endif // XINERAMA
+
+    list<WaWindow *>::iterator it = ws->wawindow_list.begin();
+    for (; it != ws->wawindow_list.end(); ++it) {
+        WaWindow *w = *it;
+        if (w == wa || w->master || w->hidden || w->flags.hidden ||
+            ! w->mapped)
+            continue;
+        WaWindowAttributes *fa = &w->frame->attrib;
+        xs.push_back(fa->x);
+        xs.push_back(fa->x + fa->width + w->border_w * 2);
+        ys.push_back(fa->y);
+        ys.push_back(fa->y + fa->height + w->border_w * 2);
+    }
+
+    std::sort(xs.begin(), xs.end());
+    std::sort(ys.begin(), ys.end());
+}
+
+/**
+ * @fn    Nearest(vector<int> &edges, int v)
+ * @brief Find nearest edge
+ *
+ * @param edges Sorted edge array
+ * @param v Position to find nearest edge for
+ *
+ * @return Nearest edge if within snap distance, otherwise v
+ */
+int SnapEdges::Nearest(vector<int> &edges, int v) {
+    vector<int>::iterator e = std::lower_bound(edges.begin(), edges.end(),
+                                               v);
+    int best = v, d = distance + 1;
+
+    if (e != edges.end() && *e - v < d) {
+        best = *e;
+        d = *e - v;
+    }
+    if (e != edges.begin() && v - *(e - 1) < d)
+        best = *(e - 1);
+
+    return best;
+}
+
+/**
+ * @fn    Delta(vector<int> &edges, int a, int b)
+ * @brief Smallest snap offset for two edges
+ *
+ * @param edges Sorted edge array
+ * @param a First edge position
+ * @param b Second edge position
+ *
+ * @return Offset that snaps the edge closest to a candidate edge
+ */
+int SnapEdges::Delta(vector<int> &edges, int a, int b) {
+    int da = Nearest(edges, a) - a;
+    int db = Nearest(edges, b) - b;
+
+    if (! da) return db;
+    if (! db) return da;
+    return (((da < 0)? -da: da) <= ((db < 0)? -db: db))? da: db;
+}
+
+/**
+ * @fn    Hold(vector<int> &edges, int from, int to, bool held)
+ * @brief Edge resistance for one edge
+ *
+ * Finds the first candidate edge crossed by an edge moving from position
+ * from to position to. A candidate edge at from only counts if the edge
+ * is already held there in the direction of the movement.
+ *
+ * @param edges Sorted edge array
+ * @param from Previous edge position
+ * @param to New edge position
+ * @param held True if edge is held at from in direction of movement
+ *
+ * @return Crossed candidate edge if to is less than edge resistance past
+ *         it, otherwise to
+ */
+int SnapEdges::Hold(vector<int> &edges, int from, int to, bool held) {
+    vector<int>::iterator e;
+
+    if (to > from) {
+        e = (held)? std::lower_bound(edges.begin(), edges.end(), from):
+            std::upper_bound(edges.begin(), edges.end(), from);
+        if (e != edges.end() && *e <= to && to - *e < resistance)
+            return *e;
+    } else if (to < from) {
+        e = (held)? std::upper_bound(edges.begin(), edges.end(), from):
+            std::lower_bound(edges.begin(), edges.end(), from);
+        if (e != edges.begin() && *(e - 1) >= to &&
+            *(e - 1) - to < resistance)
+            return *(e - 1);
+    }
+    return to;
+}
+
+/**
+ * @fn    Resist(vector<int> &edges, int last, int *pos, int size,
+ *               int *hold)
+ * @brief Edge resistance for a moving frame
+ *
+ * Holds a frame at the first candidate edge that its leading or trailing
+ * edge crossed, until it has been pushed edge resistance pixels past it.
+ *
+ * @param edges Sorted edge array
+ * @param last Previous frame position
+ * @param pos New frame position, returns held position
+ * @param size Frame size, 0 for a single edge
+ * @param hold Direction frame is held in, 0 if not held
+ *
+ * @return True if frame is held, otherwise false
+ */
+bool SnapEdges::Resist(vector<int> &edges, int last, int *pos, int size,
+                       int *hold) {
+    if (! resistance || ! tracking) return false;
+
+    int d = *pos - last;
+    int dir = (d > 0) - (d < 0);
+    if (! dir) return (*hold != 0);
+
+    int a = Hold(edges, last, *pos, *hold == dir) - *pos;
+    int b = Hold(edges, last + size, *pos + size, *hold == dir) -
+        (*pos + size);
+    int off = (((a < 0)? -a: a) >= ((b < 0)? -b: b))? a: b;
+
+    *pos += off;
+    *hold = (off)? dir: 0;
+    return (off != 0);
+}
+
+/**
+ * @fn    Move(int *x, int *y, int width, int height)
+ * @brief Snap window position
+ *
+ * Holds frame of window with client position x, y and client size width,
+ * height at crossed candidate edges, otherwise snaps it to nearest
+ * candidate edges.
+ *
+ * @param x Client x position, returns snapped position
+ * @param y Client y position, returns snapped position
+ * @param width Client width
+ * @param height Client height
+ */
+void SnapEdges::Move(int *x, int *y, int width, int height) {
+    int fx = *x - left, fy = *y - top;
+    int fw = left + width + right, fh = top + height + bottom;
+
+    if (! Resist(xs, last_x, &fx, fw, &hold_x))
+        fx += Delta(xs, fx, fx + fw);
+    if (! Resist(ys, last_y, &fy, fh, &hold_y))
+        fy += Delta(ys, fy, fy + fh);
+
+    last_x = fx;
+    last_y = fy;
+    tracking = true;
+    *x = fx + left;
+    *y = fy + top;
+}
+
+/**
+ * @fn    Resize(int x, int y, int *width, int *height, int how)
+ * @brief Snap window size
+ *
+ * Holds moving horizontal frame edge and bottom frame edge of window at
+ * crossed candidate edges, otherwise snaps them to nearest candidate
+ * edges.
+ *
+ * @param x Client left edge if how is EastType, otherwise client right edge
+ * @param y Client top edge
+ * @param width Client width, returns snapped width
+ * @param height Client height, returns snapped height
+ * @param how EastType or WestType
+ */
+void SnapEdges::Resize(int x, int y, int *width, int *height, int how) {
+    int ex = (how > 0)? x + *width + right: x - *width - left;
+    int ey = y + *height + bottom;
+
+    if (! Resist(xs, last_x, &ex, 0, &hold_x)) ex = Nearest(xs, ex);
+    if (! Resist(ys, last_y, &ey, 0, &hold_y)) ey = Nearest(ys, ey);
+
+    last_x = ex;
+    last_y = ey;
+    tracking = true;
+    if (how > 0)
+        *width = ex - right - x;
+    else
+        *width = x - (ex + left);
+    *height = ey - bottom - y;
+}
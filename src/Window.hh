@@ -25,8 +25,13 @@ extern "C" {
 #endif // SHAPE
 }
 
+#include <vector>
+using std::vector;
+
 class WaWindow;
 class WaChildWindow;
+class SnapEdges;
+class WaIcon;
 
 typedef struct _WaAction WaAction;
 typedef void (WaWindow::*WwActionFn)(XEvent *, WaAction *);
@@ -60,6 +65,11 @@ typedef struct {
     int base_width;
     int base_height;
     int win_gravity;
+    int min_aspect_x;
+    int min_aspect_y;
+    int max_aspect_x;
+    int max_aspect_y;
+    bool base_size;
 } SizeStruct;
 
 typedef struct {
@@ -97,15 +107,21 @@ public:
     void Show(void);
     void Hide(void);
     void UpdateTitlebar(void);
+    void SetName(char *);
     void UpdateAllAttributes(void);
     list <WaAction *> *GetActionList(list<WaActionExtList *> *);
     void SetActionLists(void);
+    WaWindowRule *ApplyRules(void);
     void RedrawWindow(bool = false);
+    void ShadeClients(void);
+    void FocusClient(void);
     void SendConfig(void);
     void Gravitate(int);
     void UpdateGrabs(void);
+    void UpdateKeyGrabs(map<KeySym, unsigned int> *);
     void ButtonPressed(WaChildWindow *);
     bool IncSizeCheck(int, int, int *, int *);
+    void ConstrainSize(int *, int *);
     void DrawTitlebar(bool = false);
     void DrawHandlebar(bool = false);
     void FocusWin(void);
@@ -234,10 +250,19 @@ public:
     void JoinDesktop(XEvent *, WaAction *);
     void PartCurrentJoinDesktop(XEvent *, WaAction *);
     void PartDesktop(XEvent *, WaAction *);
+    void JoinDesktopMatch(XEvent *, WaAction *);
+    void PartDesktopMatch(XEvent *, WaAction *);
+    void DesktopMaskMatch(XEvent *, WaAction *);
     void PartCurrentDesktop(XEvent *, WaAction *);
     void JoinCurrentDesktop(void);
     void JoinAllDesktops(XEvent *, WaAction *);
     void PartAllDesktopsExceptCurrent(XEvent *, WaAction *);
+    void GroupRaise(XEvent *, WaAction *);
+    void GroupLower(XEvent *, WaAction *);
+    void GroupMinimize(XEvent *, WaAction *);
+    void GroupUnMinimize(XEvent *, WaAction *);
+    void GroupClose(XEvent *, WaAction *);
+    void GroupPartCurrentJoinDesktop(XEvent *, WaAction *);
     void MergeWithWindow(WaAction *, int);
     void CloneMergeWithWindow(XEvent *, WaAction *ac) {
         MergeWithWindow(ac, CloneMergeType);
@@ -274,8 +299,10 @@ public:
 
     char *name, *host, *pid;
     int realnamelen;
+    WaText name_text;
     bool has_focus, want_focus, mapped, dontsend, deleted, ign_config_req,
-                   hidden;
+                   hidden, client_unmapped, input_hint, take_focus;
+    int ign_unmap;
     Display *display;
     Waimea *waimea;
     WaScreen *wascreen;
@@ -287,7 +314,13 @@ public:
     SizeStruct size;
     NetHandler *net;
     WMstrut *wm_strut;
-    Window transient_for;
+    WaIcon *icon;
+    Window transient_for, group;
+    long frame_extents[4];
+    list<XEvent *> req_queue;
+    struct timeval req_time;
+    double req_tokens;
+    bool req_throttled;
     XClassHint *classhint;
     list<Window> transients;
     unsigned int desktop_mask;
@@ -310,9 +343,10 @@ private:
     void Resize(XEvent *, int);
     void ResizeOpaque(XEvent *, int);
     bool _MoveOpaque(XEvent *, int, int, int, int, list<XEvent *> *);
+    void SetMinimizeState(int);
+    bool AcceptsDelete(void);
 
     WaImageControl *ic;
-    Window o_west, o_north, o_south, o_east;
     bool move_resize, sendcf, pos_init;
 
 #ifdef SHAPE
@@ -346,4 +380,26 @@ public:
 
 };
 
+class SnapEdges {
+public:
+    SnapEdges(WaWindow *, int, int);
+
+    void Update(void);
+    void Move(int *, int *, int, int);
+    void Resize(int, int, int *, int *, int);
+
+private:
+    int Nearest(vector<int> &, int);
+    int Delta(vector<int> &, int, int);
+    int Hold(vector<int> &, int, int, bool);
+    bool Resist(vector<int> &, int, int *, int, int *);
+
+    WaWindow *wa;
+    vector<int> xs, ys;
+    int distance, resistance;
+    int left, right, top, bottom;
+    bool tracking;
+    int last_x, last_y, hold_x, hold_y;
+};
+
 #endif // __Window_hh